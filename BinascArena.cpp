@@ -0,0 +1,165 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Mon Oct 19 00:31:20 PDT 2026
+// Last Modified: Mon Oct 19 00:31:20 PDT 2026
+// Filename:      ...binasc/BinascArena.cpp
+// Syntax:        C++
+//
+// Description:   A bump allocator for short-lived compiler storage.
+//
+
+#include "BinascArena.h"
+
+#include <string.h>
+
+// Allocations are rounded up to this size so that any type can be stored.
+#define ARENA_ALIGN  8
+
+
+//////////////////////////////
+//
+// BinascArena::BinascArena -- no memory is allocated until it is needed.
+//
+
+BinascArena::BinascArena(void) {
+   first   = NULL;
+   current = NULL;
+   used    = 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascArena::~BinascArena --
+//
+
+BinascArena::~BinascArena() {
+   while (first != NULL) {
+      ArenaBlock* next = first->next;
+      delete [] (char*)first;
+      first = next;
+   }
+}
+
+
+
+//////////////////////////////
+//
+// BinascArena::allocate -- returns size bytes of memory, aligned for any
+//     type, which stay valid until the arena is rewound past them or
+//     cleared.  Blocks left over from earlier use are filled before new
+//     ones are allocated.
+//
+
+void* BinascArena::allocate(size_t size) {
+   size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+   if (current != NULL && used + size <= current->size) {
+      void* memory = (char*)(current + 1) + used;
+      used += size;
+      return memory;
+   }
+
+   if (current == NULL && first != NULL && size <= first->size) {
+      current = first;
+   } else if (current != NULL && current->next != NULL &&
+         size <= current->next->size) {
+      current = current->next;
+   } else {
+      size_t blockSize = ARENA_BLOCK;
+      if (current != NULL) {
+         blockSize = current->size * 2;
+      }
+      while (blockSize < size) {
+         blockSize *= 2;
+      }
+      ArenaBlock* block = newBlock(blockSize);
+      if (current == NULL) {
+         block->next = first;
+         first = block;
+      } else {
+         block->next = current->next;
+         current->next = block;
+      }
+      current = block;
+   }
+   used = size;
+   return current + 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascArena::copy -- store a copy of a null-terminated string.
+//
+
+char* BinascArena::copy(const char* text) {
+   size_t length = strlen(text) + 1;
+   char* output = (char*)allocate(length);
+   memcpy(output, text, length);
+   return output;
+}
+
+
+
+//////////////////////////////
+//
+// BinascArena::getMark -- returns the current position, so that everything
+//     allocated after it can be given back with release().
+//
+
+ArenaMark BinascArena::getMark(void) const {
+   ArenaMark mark;
+   mark.block = current;
+   mark.used  = used;
+   return mark;
+}
+
+
+
+//////////////////////////////
+//
+// BinascArena::release -- give back everything allocated since the mark
+//     was taken.  The blocks stay in the arena for later allocations.
+//
+
+void BinascArena::release(const ArenaMark& mark) {
+   current = (ArenaBlock*)mark.block;
+   used    = mark.used;
+}
+
+
+
+//////////////////////////////
+//
+// BinascArena::clear -- give back everything allocated from the arena,
+//     keeping its blocks.
+//
+
+void BinascArena::clear(void) {
+   current = NULL;
+   used    = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+
+//////////////////////////////
+//
+// BinascArena::newBlock -- allocate a block with room for size bytes.
+//
+
+BinascArena::ArenaBlock* BinascArena::newBlock(size_t size) {
+   ArenaBlock* block = (ArenaBlock*)new char[sizeof(ArenaBlock) + size];
+   block->next = NULL;
+   block->size = size;
+   return block;
+}
+
+
+
@@ -0,0 +1,65 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Mon Oct 19 00:31:20 PDT 2026
+// Last Modified: Mon Oct 19 00:31:20 PDT 2026
+// Filename:      ...binasc/BinascArena.h
+// Syntax:        C++
+//
+// Description:   A bump allocator for short-lived compiler storage.
+//                Memory is handed out from large blocks by moving a
+//                pointer, and is given back all at once, either by
+//                rewinding to a mark or by clearing the arena.  Blocks
+//                are kept for reuse, so a compiler which clears its
+//                arena between runs stops using the heap once its blocks
+//                are large enough.  An arena belongs to one thread.
+//
+
+#ifndef _BINASCARENA_H_INCLUDED
+#define _BINASCARENA_H_INCLUDED
+
+#include <stddef.h>
+
+// Size of the first block; larger requests get a block of their own.
+#define ARENA_BLOCK  (64 * 1024)
+
+
+// An ArenaMark is a position in an arena to rewind to.
+class ArenaMark {
+   public:
+      void*          block;        // block in use at the mark
+      size_t         used;         // bytes used in that block
+};
+
+
+class BinascArena {
+   public:
+                     BinascArena           (void);
+                    ~BinascArena           ();
+
+      void*          allocate              (size_t size);
+      char*          copy                  (const char* text);
+      ArenaMark      getMark               (void) const;
+      void           release               (const ArenaMark& mark);
+      void           clear                 (void);
+
+   protected:
+      // An ArenaBlock is followed in memory by its bytes.
+      class ArenaBlock {
+         public:
+            ArenaBlock*  next;     // following block, or NULL
+            size_t       size;     // number of bytes after the header
+      };
+
+      ArenaBlock*    first;        // first block, or NULL
+      ArenaBlock*    current;      // block being handed out
+      size_t         used;         // bytes handed out from current
+
+      ArenaBlock*    newBlock              (size_t size);
+};
+
+
+
+#endif  /* _BINASCARENA_H_INCLUDED */
+
+
+
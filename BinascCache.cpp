@@ -0,0 +1,400 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 21:17:45 PDT 2026
+// Last Modified: Sun Oct 18 21:17:45 PDT 2026
+// Last Modified: Mon Oct 19 08:06:12 PDT 2026 Keys built one input at a time
+// Filename:      ...binasc/BinascCache.cpp
+// Syntax:        C++
+//
+// Description:   A directory of compiled files, named by a hash of the
+//                source text which made them.
+//
+
+#include "BinascCache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// constants of the XXH64 hash
+#define PRIME1 0x9E3779B185EBCA87ULL
+#define PRIME2 0xC2B2AE3D27D4EB4FULL
+#define PRIME3 0x165667B19E3779F9ULL
+#define PRIME4 0x85EBCA77C2B2AE63ULL
+#define PRIME5 0x27D4EB2F165667C5ULL
+
+
+//////////////////////////////
+//
+// rotate -- rotate the bits of a 64-bit word to the left.
+//
+
+static inline ulonglong rotate(ulonglong value, int bits) {
+   return (value << bits) | (value >> (64 - bits));
+}
+
+
+
+//////////////////////////////
+//
+// readLittle -- read a little-endian number of 4 or 8 bytes.  Compilers
+//     turn this into a single load on little-endian computers.
+//
+
+static inline ulonglong readLittle(const uchar* input, int count) {
+   ulonglong value = 0;
+   for (int i=count-1; i>=0; i--) {
+      value = (value << 8) | input[i];
+   }
+   return value;
+}
+
+
+
+//////////////////////////////
+//
+// mixLane -- add 8 bytes of input into one of the four hash lanes.
+//
+
+static inline ulonglong mixLane(ulonglong lane, ulonglong input) {
+   lane += input * PRIME2;
+   lane  = rotate(lane, 31);
+   return lane * PRIME1;
+}
+
+
+
+//////////////////////////////
+//
+// mergeLane -- fold one of the four hash lanes into the hash.
+//
+
+static inline ulonglong mergeLane(ulonglong hash, ulonglong lane) {
+   hash ^= mixLane(0, lane);
+   return hash * PRIME1 + PRIME4;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::BinascCache --
+//
+
+BinascCache::BinascCache(void) {
+   hits   = 0;
+   misses = 0;
+   stores = 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::~BinascCache --
+//
+
+BinascCache::~BinascCache() {
+   // do nothing
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::open -- use the given directory for the cache, creating
+//     it if needed.  Returns 0 if the directory cannot be used.
+//
+
+int BinascCache::open(const char* path) {
+   directory.clear();
+   errorMessage.clear();
+   struct stat info;
+   if (mkdir(path, 0777) != 0 && errno != EEXIST) {
+      errorMessage = string("cannot create cache directory ") + path + ": "
+            + strerror(errno);
+      return 0;
+   }
+   if (stat(path, &info) != 0 || !S_ISDIR(info.st_mode)) {
+      errorMessage = string("cache is not a directory: ") + path;
+      return 0;
+   }
+   directory = path;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::is_open -- returns true if a cache directory is in use.
+//
+
+int BinascCache::is_open(void) const {
+   return !directory.empty();
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::getError -- returns the reason open() failed.
+//
+
+const char* BinascCache::getError(void) const {
+   return errorMessage.c_str();
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::getKey -- returns the cache key for compiling the given
+//     inputs in order.  The key depends on the compiler version as well
+//     as the text of each input.
+//
+
+ulonglong BinascCache::getKey(const vector<string>& inputs) const {
+   ulonglong key = getKey();
+   for (int i=0; i<(int)inputs.size(); i++) {
+      key = addToKey(key, inputs[i].data(), inputs[i].size());
+   }
+   return key;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::getKey -- returns the key for no inputs, which depends only
+//     on the compiler version.  Inputs are added with addToKey(), so that
+//     they do not have to be in memory at the same time.
+//
+
+ulonglong BinascCache::getKey(void) const {
+   return hash(BINASC_CACHE_VERSION, strlen(BINASC_CACHE_VERSION));
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::addToKey -- returns the key for the inputs of key followed
+//     by one more input.
+//
+
+ulonglong BinascCache::addToKey(ulonglong key, const void* input,
+      size_t size) const {
+   return hash(input, size, key);
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::fetch -- copy the cached output for a key into out.
+//     Returns 0 if the key is not in the cache.
+//
+
+int BinascCache::fetch(ulonglong key, OutputBuffer& out) {
+   if (!is_open()) {
+      return 0;
+   }
+   int infd = ::open(getEntryName(key).c_str(), O_RDONLY);
+   struct stat info;
+   if (infd < 0 || fstat(infd, &info) != 0) {
+      if (infd >= 0) {
+         close(infd);
+      }
+      misses++;
+      return 0;
+   }
+   int status = out.copyFrom(infd, 0, (ulonglong)info.st_size);
+   close(infd);
+   if (status) {
+      hits++;
+   } else {
+      misses++;
+   }
+   return status;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::store -- add a compiled file to the cache.  The file is
+//     copied under a temporary name and then renamed, so that other
+//     programs using the cache never see part of an entry.  Only regular
+//     files can be stored.  Returns 0 if the file was not stored.
+//
+
+int BinascCache::store(ulonglong key, const char* filename) {
+   if (!is_open()) {
+      return 0;
+   }
+   int infd = ::open(filename, O_RDONLY);
+   struct stat info;
+   if (infd < 0 || fstat(infd, &info) != 0 || !S_ISREG(info.st_mode)) {
+      if (infd >= 0) {
+         close(infd);
+      }
+      return 0;
+   }
+
+   string entry = getEntryName(key);
+   mkdir(entry.substr(0, entry.rfind('/')).c_str(), 0777);
+   string temporary = entry + ".XXXXXX";
+   int tempfd = mkstemp(&temporary[0]);
+   if (tempfd < 0) {
+      close(infd);
+      return 0;
+   }
+   close(tempfd);
+
+   OutputBuffer out;
+   int status = out.open(temporary.c_str()) &&
+         out.copyFrom(infd, 0, (ulonglong)info.st_size);
+   out.close();
+   close(infd);
+   if (!status || !out.good() || rename(temporary.c_str(),
+         entry.c_str()) != 0) {
+      unlink(temporary.c_str());
+      return 0;
+   }
+   stores++;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::getHits -- returns the number of outputs which were found
+//     in the cache.
+//
+
+int BinascCache::getHits(void) const {
+   return hits;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::getMisses -- returns the number of outputs which were not
+//     found in the cache.
+//
+
+int BinascCache::getMisses(void) const {
+   return misses;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::getStores -- returns the number of outputs which were
+//     added to the cache.
+//
+
+int BinascCache::getStores(void) const {
+   return stores;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCache::hash -- the 64-bit XXH64 hash of a block of bytes.  Four
+//     lanes take 32 bytes at a time, then the last bytes are mixed in
+//     one by one.
+//
+
+ulonglong BinascCache::hash(const void* data, size_t size, ulonglong seed) {
+   const uchar* input  = (const uchar*)data;
+   const uchar* ending = input + size;
+   ulonglong value;
+
+   if (size >= 32) {
+      ulonglong lane1 = seed + PRIME1 + PRIME2;
+      ulonglong lane2 = seed + PRIME2;
+      ulonglong lane3 = seed;
+      ulonglong lane4 = seed - PRIME1;
+      const uchar* limit = ending - 32;
+      do {
+         lane1 = mixLane(lane1, readLittle(input,      8));
+         lane2 = mixLane(lane2, readLittle(input + 8,  8));
+         lane3 = mixLane(lane3, readLittle(input + 16, 8));
+         lane4 = mixLane(lane4, readLittle(input + 24, 8));
+         input += 32;
+      } while (input <= limit);
+      value = rotate(lane1, 1) + rotate(lane2, 7) + rotate(lane3, 12) +
+            rotate(lane4, 18);
+      value = mergeLane(value, lane1);
+      value = mergeLane(value, lane2);
+      value = mergeLane(value, lane3);
+      value = mergeLane(value, lane4);
+   } else {
+      value = seed + PRIME5;
+   }
+   value += (ulonglong)size;
+
+   while (input + 8 <= ending) {
+      value ^= mixLane(0, readLittle(input, 8));
+      value  = rotate(value, 27) * PRIME1 + PRIME4;
+      input += 8;
+   }
+   if (input + 4 <= ending) {
+      value ^= readLittle(input, 4) * PRIME1;
+      value  = rotate(value, 23) * PRIME2 + PRIME3;
+      input += 4;
+   }
+   while (input < ending) {
+      value ^= (*input) * PRIME5;
+      value  = rotate(value, 11) * PRIME1;
+      input++;
+   }
+
+   value ^= value >> 33;
+   value *= PRIME2;
+   value ^= value >> 29;
+   value *= PRIME3;
+   value ^= value >> 32;
+   return value;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+
+//////////////////////////////
+//
+// BinascCache::getEntryName -- the file which holds the output for a key.
+//     The first two hexadecimal digits of the key name a subdirectory,
+//     so that no directory grows too large.
+//
+
+string BinascCache::getEntryName(ulonglong key) const {
+   static const char hexDigits[] = "0123456789abcdef";
+   string name = directory + "/xx/xxxxxxxxxxxxxx";
+   size_t position = directory.size() + 1;
+   for (int i=15; i>=0; i--) {
+      if (i == 13) {
+         position++;     // skip the slash after the subdirectory
+      }
+      name[position++] = hexDigits[(key >> (i * 4)) & 0x0f];
+   }
+   return name;
+}
+
+
+
@@ -0,0 +1,71 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 21:17:45 PDT 2026
+// Last Modified: Sun Oct 18 21:17:45 PDT 2026
+// Last Modified: Mon Oct 19 08:06:12 PDT 2026 Keys built one input at a time
+// Filename:      ...binasc/BinascCache.h
+// Syntax:        C++
+//
+// Description:   A directory of compiled files, named by a hash of the
+//                source text which made them.  When a source has been
+//                compiled before, its output is copied from the cache
+//                instead of being compiled again.  The copy is done by
+//                the kernel, and shares the blocks of the cached file on
+//                filesystems which allow it.
+//
+
+#ifndef _BINASCCACHE_H_INCLUDED
+#define _BINASCCACHE_H_INCLUDED
+
+#include "OutputBuffer.h"
+
+#include <string>
+#include <vector>
+#include <atomic>
+
+// Change BINASC_CACHE_VERSION whenever the compiler would give different
+// bytes for the same source, so that older cache entries are not used.
+#define BINASC_CACHE_VERSION "binasc compiler 2026-10-18"
+
+
+class BinascCache {
+   public:
+                     BinascCache           (void);
+                    ~BinascCache           ();
+
+      int            open                  (const char* path);
+      int            is_open               (void) const;
+      const char*    getError              (void) const;
+
+      ulonglong      getKey                (const std::vector<std::string>&
+                                            inputs) const;
+      ulonglong      getKey                (void) const;
+      ulonglong      addToKey              (ulonglong key, const void* input,
+                                            size_t size) const;
+      int            fetch                 (ulonglong key, OutputBuffer& out);
+      int            store                 (ulonglong key,
+                                            const char* filename);
+
+      int            getHits               (void) const;
+      int            getMisses             (void) const;
+      int            getStores             (void) const;
+
+      static ulonglong hash                (const void* data, size_t size,
+                                            ulonglong seed = 0);
+
+   protected:
+      std::string    directory;    // cache directory, or empty
+      std::string    errorMessage; // reason open() failed
+      std::atomic<int> hits;       // outputs found in the cache
+      std::atomic<int> misses;     // outputs not found in the cache
+      std::atomic<int> stores;     // outputs added to the cache
+
+      std::string    getEntryName          (ulonglong key) const;
+};
+
+
+
+#endif  /* _BINASCCACHE_H_INCLUDED */
+
+
+
@@ -0,0 +1,260 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 19:58:31 PDT 2026
+// Last Modified: Sun Oct 18 19:58:31 PDT 2026
+// Last Modified: Mon Oct 19 05:20:44 PDT 2026 Send threads and merge
+// Filename:      ...binasc/BinascClient.cpp
+// Syntax:        C++
+//
+// Description:   Sends compile and listing requests to a binasc server
+//                and collects the replies.
+//
+
+#include "BinascClient.h"
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+
+
+//////////////////////////////
+//
+// BinascClient::BinascClient --
+//
+
+BinascClient::BinascClient(void) {
+   fd = -1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascClient::~BinascClient --
+//
+
+BinascClient::~BinascClient() {
+   close();
+}
+
+
+
+//////////////////////////////
+//
+// BinascClient::open -- connect to the server listening on the given
+//     socket.  Returns 0 if there is no server.
+//
+
+int BinascClient::open(const char* path) {
+   close();
+   errorMessage.clear();
+
+   struct sockaddr_un address = {};
+   address.sun_family = AF_UNIX;
+   if (strlen(path) >= sizeof(address.sun_path)) {
+      return fail(string("socket path is too long: ") + path);
+   }
+   strcpy(address.sun_path, path);
+
+   fd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (fd < 0) {
+      return fail(string("cannot create socket: ") + strerror(errno));
+   }
+   if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+      int problem = errno;
+      close();
+      return fail(string("cannot connect to ") + path + ": " +
+            strerror(problem));
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascClient::close -- end the connection.
+//
+
+void BinascClient::close(void) {
+   if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+   }
+}
+
+
+
+//////////////////////////////
+//
+// BinascClient::beginCompile -- start a request to compile the inputs
+//     which follow.  With checkQ, every error is reported and no output
+//     is sent back.  Returns 0 if the request could not be sent.
+//
+
+int BinascClient::beginCompile(int checkQ) {
+   uchar flag = checkQ ? 1 : 0;
+   errors.clear();
+   errorMessage.clear();
+   if (!writeFrame(fd, FRAME_COMPILE, &flag, 1)) {
+      return fail("cannot send request to the server");
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascClient::beginListing -- start a request to list the inputs which
+//     follow in the given format.  Returns 0 if the request could not
+//     be sent.
+//
+
+int BinascClient::beginListing(const BinascFormat& format) {
+   uchar fields[24];
+   storeFrameInt(format.style,        fields);
+   storeFrameInt(format.bytesPerLine, fields + 4);
+   storeFrameInt(format.wrap,         fields + 8);
+   storeFrameInt(format.commentQ,     fields + 12);
+   storeFrameInt(format.threads,      fields + 16);
+   storeFrameInt(format.mergeQ,       fields + 20);
+   errors.clear();
+   errorMessage.clear();
+   if (!writeFrame(fd, FRAME_LIST, fields, sizeof(fields))) {
+      return fail("cannot send request to the server");
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascClient::sendInput -- send the contents of one input file.
+//     Returns 0 if the input could not be sent.
+//
+
+int BinascClient::sendInput(istream& input) {
+   char block[OUTPUTBUFFER_BLOCK];
+   while (input.read(block, sizeof(block)) || input.gcount() > 0) {
+      if (!writeFrame(fd, FRAME_INPUT, block, input.gcount())) {
+         return fail("cannot send input to the server");
+      }
+   }
+   if (!writeFrame(fd, FRAME_INPUT_END, NULL, 0)) {
+      return fail("cannot send input to the server");
+   }
+   return 1;
+}
+
+
+int BinascClient::sendInput(const char* data, size_t size) {
+   while (size > 0) {
+      size_t count = size < OUTPUTBUFFER_BLOCK ? size : OUTPUTBUFFER_BLOCK;
+      if (!writeFrame(fd, FRAME_INPUT, data, count)) {
+         return fail("cannot send input to the server");
+      }
+      data += count;
+      size -= count;
+   }
+   if (!writeFrame(fd, FRAME_INPUT_END, NULL, 0)) {
+      return fail("cannot send input to the server");
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascClient::finish -- end the request and write its output into
+//     out.  Returns 0 if there were errors, which are then given by
+//     getErrors() and getError().
+//
+
+int BinascClient::finish(OutputBuffer& out) {
+   if (!writeFrame(fd, FRAME_REQUEST_END, NULL, 0)) {
+      return fail("cannot send request to the server");
+   }
+
+   string data;
+   int type;
+   while (readFrame(fd, type, data)) {
+      switch (type) {
+         case FRAME_OUTPUT:
+            out.write(data.data(), data.size());
+            break;
+         case FRAME_ERROR:
+            if (data.size() >= 4) {
+               BinascError error;
+               error.lineNumber = loadFrameInt((const uchar*)data.data());
+               size_t ending = data.find('\0', 4);
+               if (ending == string::npos) {
+                  ending = data.size();
+               }
+               error.token = data.substr(4, ending - 4);
+               if (ending < data.size()) {
+                  error.message = data.substr(ending + 1);
+               }
+               errors.push_back(error);
+            }
+            break;
+         case FRAME_MESSAGE:
+            errorMessage = data;
+            break;
+         case FRAME_STATUS:
+            return errors.empty() && errorMessage.empty();
+      }
+   }
+   close();
+   return fail("connection to the server was lost");
+}
+
+
+
+//////////////////////////////
+//
+// BinascClient::getErrors -- returns the errors in the input text which
+//     were found by the server.
+//
+
+const vector<BinascError>& BinascClient::getErrors(void) const {
+   return errors;
+}
+
+
+
+//////////////////////////////
+//
+// BinascClient::getError -- returns an error which is not in the input
+//     text, such as a lost connection, or an empty string.
+//
+
+const char* BinascClient::getError(void) const {
+   return errorMessage.c_str();
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+
+//////////////////////////////
+//
+// BinascClient::fail -- remember an error.  Always returns 0.
+//
+
+int BinascClient::fail(const string& message) {
+   errorMessage = message;
+   return 0;
+}
+
+
+
@@ -0,0 +1,57 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 19:58:31 PDT 2026
+// Last Modified: Sun Oct 18 19:58:31 PDT 2026
+// Filename:      ...binasc/BinascClient.h
+// Syntax:        C++
+//
+// Description:   Sends compile and listing requests to a binasc server
+//                (see BinascServer.h) and collects the replies.  The
+//                output of a request goes into an OutputBuffer, and errors
+//                in the input text are returned as BinascError values, as
+//                if the work had been done by BinascCompiler.
+//
+
+#ifndef _BINASCCLIENT_H_INCLUDED
+#define _BINASCCLIENT_H_INCLUDED
+
+#include "BinascProtocol.h"
+#include "BinascCompiler.h"
+#include "BinascFormatter.h"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+
+class BinascClient {
+   public:
+                     BinascClient          (void);
+                    ~BinascClient          ();
+
+      int            open                  (const char* path);
+      void           close                 (void);
+
+      int            beginCompile          (int checkQ = 0);
+      int            beginListing          (const BinascFormat& format);
+      int            sendInput             (std::istream& input);
+      int            sendInput             (const char* data, size_t size);
+      int            finish                (OutputBuffer& out);
+
+      const std::vector<BinascError>& getErrors (void) const;
+      const char*    getError              (void) const;
+
+   protected:
+      int            fd;           // connection to the server, or -1
+      std::vector<BinascError> errors; // errors in the input text
+      std::string    errorMessage; // other error, or empty
+
+      int            fail                  (const std::string& message);
+};
+
+
+
+#endif  /* _BINASCCLIENT_H_INCLUDED */
+
+
+
@@ -0,0 +1,1745 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 18:05:12 PDT 2026
+// Last Modified: Sun Oct 18 18:05:12 PDT 2026
+// Last Modified: Sun Oct 18 21:17:45 PDT 2026 Added getIncludedFiles()
+// Last Modified: Sun Oct 18 22:03:26 PDT 2026 Added usesLabels()
+// Last Modified: Sun Oct 18 23:46:15 PDT 2026 Added setListing()
+// Last Modified: Mon Oct 19 00:31:20 PDT 2026 Arena for words and errors
+// Last Modified: Mon Oct 19 01:14:38 PDT 2026 Added #define and #macro
+// Last Modified: Mon Oct 19 05:34:02 PDT 2026 Repeat counts checked
+// Last Modified: Mon Oct 19 05:48:27 PDT 2026 incbin files always closed
+// Last Modified: Mon Oct 19 07:44:10 PDT 2026 Expression overflow checked
+// Last Modified: Mon Oct 19 07:52:38 PDT 2026 Label errors in line order
+// Last Modified: Mon Oct 19 08:30:57 PDT 2026 Hexadecimal bytes read first
+// Filename:      ...binasc/BinascCompiler.cpp
+// Syntax:        C++
+//
+// Description:   Compiles binasc text into bytes.  All of the state for a
+//                compilation is kept in the object, so that a program can
+//                run any number of compilations without starting binasc.
+//                Errors are collected in a list rather than printed, and
+//                the bytes go into an OutputBuffer, which can be memory,
+//                a file, or a function supplied by the caller.
+//
+
+#include "BinascCompiler.h"
+#include "ByteCodec.h"
+
+#include <charconv>
+#include <algorithm>
+
+#include <stdlib.h>
+#include <limits.h>
+#include <ctype.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// Classes of characters while a line is split into words:
+#define CHAR_WORD       0    // part of a word
+#define CHAR_SEPARATOR  1    // space, tab or newline
+#define CHAR_END        2    // null at the end of the line
+#define CHAR_QUOTE      3    // double quote, which starts a string
+
+static const uchar charClasses[256] = {
+   2, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0,  // 00
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 10
+   1, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 20
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 30
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 40
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 50
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 60
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 70
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 80
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // 90
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // a0
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // b0
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // c0
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // d0
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  // e0
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0   // f0
+};
+
+// Values of hexadecimal digits, or XX for other characters.
+#define XX 0xff
+static const uchar hexValues[256] = {
+   XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // 00
+   XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // 10
+   XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // 20
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9,XX,XX,XX,XX,XX,XX,  // 30
+   XX,10,11,12,13,14,15,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // 40
+   XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // 50
+   XX,10,11,12,13,14,15,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // 60
+   XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // 70
+   XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // 80
+   XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // 90
+   XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // a0
+   XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // b0
+   XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // c0
+   XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // d0
+   XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,  // e0
+   XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX   // f0
+};
+#undef XX
+
+
+
+//////////////////////////////
+//
+// readShortHex -- returns 1 and the byte if a word is one or two
+//     hexadecimal digits, the most common word in binasc text.
+//
+
+static inline int readShortHex(const char* word, uchar& value) {
+   uchar high = hexValues[(uchar)word[0]];
+   if (high == 0xff) {
+      return 0;
+   }
+   if (word[1] == '\0') {
+      value = high;
+      return 1;
+   }
+   uchar low = hexValues[(uchar)word[1]];
+   if (low == 0xff || word[2] != '\0') {
+      return 0;
+   }
+   value = (uchar)((high << 4) | low);
+   return 1;
+}
+
+
+//////////////////////////////
+//
+// MessageBuffer::MessageBuffer -- the text goes into the fixed array,
+//     leaving room for a null at the end.
+//
+
+MessageBuffer::MessageBuffer(void) {
+   clear();
+}
+
+
+
+//////////////////////////////
+//
+// MessageBuffer::getText -- returns the message written so far.
+//
+
+const char* MessageBuffer::getText(void) {
+   *pptr() = '\0';
+   return text;
+}
+
+
+
+//////////////////////////////
+//
+// MessageBuffer::clear -- start a new message.
+//
+
+void MessageBuffer::clear(void) {
+   setp(text, text + MESSAGE_SIZE - 1);
+}
+
+
+
+//////////////////////////////
+//
+// MessageBuffer::overflow -- called when the array is full: the rest of
+//     the message is dropped.
+//
+
+int MessageBuffer::overflow(int character) {
+   return character == traits_type::eof() ? traits_type::not_eof(character)
+         : character;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::BinascCompiler --
+//
+
+BinascCompiler::BinascCompiler(void) : errorText(&messageBuffer) {
+   output       = &memoryOutput;
+   listing      = NULL;
+   lineNumber   = 0;
+   inputSize    = 0;
+   keepGoingQ   = 0;
+   outputErrorQ = 0;
+   firstError   = NULL;
+   lastError    = NULL;
+   errorCount   = 0;
+   listedError  = NULL;
+   macroBlock   = NULL;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::~BinascCompiler --
+//
+
+BinascCompiler::~BinascCompiler() {
+   // do nothing
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::setOutput -- send the compiled bytes to an output
+//     buffer owned by the caller.  The buffer can be a file, memory, or
+//     a sink function.
+//
+
+void BinascCompiler::setOutput(OutputBuffer& out) {
+   output = &out;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::getOutput -- returns the output buffer; by default this
+//     is a memory buffer holding all of the compiled bytes.
+//
+
+OutputBuffer& BinascCompiler::getOutput(void) {
+   return *output;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::setKeepGoing -- when true, compiling continues after an
+//     error so that all of the errors in the input are found.  Otherwise
+//     the rest of the input is ignored after the first error.
+//
+
+void BinascCompiler::setKeepGoing(int state) {
+   keepGoingQ = state;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::setListing -- record the output offset and byte count
+//     of each compiled line in a listing owned by the caller, or stop
+//     recording if NULL.
+//
+
+void BinascCompiler::setListing(BinascListing* aListing) {
+   listing = aListing;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::clear -- forget labels and errors so that the compiler
+//     can be used again.  A memory output buffer is emptied as well.
+//
+
+void BinascCompiler::clear(void) {
+   labelOffsets.clear();
+   labelFixups.clear();
+   labelWaiting.clear();
+   macros.clear();
+   macroBlock = NULL;
+   errorArena.clear();
+   scratchArena.clear();
+   firstError  = NULL;
+   lastError   = NULL;
+   errorCount  = 0;
+   errors.clear();
+   listedError = NULL;
+   messageBuffer.clear();
+   errorText.clear();
+   includedFiles.clear();
+   lineNumber   = 0;
+   inputSize    = 0;
+   outputErrorQ = 0;
+   memoryOutput.clear();
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::compileLine -- compile the next line of the input.  The
+//     line is modified while its words are separated.  Returns 0 if
+//     there are any errors so far.
+//
+
+int BinascCompiler::compileLine(char* line) {
+   lineNumber++;
+   if (errorCount != 0 && !keepGoingQ) {
+      return 0;
+   }
+   ulonglong start = output->tell();
+   processLine(line, lineNumber, *output);
+   if (listing != NULL) {
+      listing->addLine(lineNumber, start, output->tell() - start);
+   }
+   checkOutput();
+   return errorCount == 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::compileText -- compile lines of text.  Line numbers
+//     start again at 1.  Returns 0 if there are any errors so far.
+//
+
+int BinascCompiler::compileText(const char* text, size_t length) {
+   string line;
+   const char* ending = text + length;
+   lineNumber = 0;
+   while (text < ending) {
+      const char* newline = (const char*)memchr(text, '\n', ending - text);
+      if (newline == NULL) {
+         newline = ending;
+      }
+      line.assign(text, newline - text);
+      inputSize += line.size() + 1;
+      if (!compileLine(&line[0]) && !keepGoingQ) {
+         return 0;
+      }
+      text = newline + 1;
+   }
+   return errorCount == 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::compileStream -- compile the lines of a file or other
+//     stream.  Line numbers start again at 1.  Lines can be any length,
+//     and a last line without a newline is read.  Returns 0 if there are
+//     any errors so far.
+//
+
+int BinascCompiler::compileStream(istream& input) {
+   string line;
+   lineNumber = 0;
+   while (getline(input, line)) {
+      inputSize += line.size() + 1;
+      if (!compileLine(&line[0]) && !keepGoingQ) {
+         return 0;
+      }
+   }
+   return errorCount == 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::finish -- call after all of the input has been compiled
+//     to check that every label was defined.  The output is not closed.
+//     Returns 0 if there are any errors.
+//
+
+int BinascCompiler::finish(void) {
+   if (macroBlock != NULL) {
+      errorText << "macro " << macroBlock->name << " has no #endmacro";
+      error(macroBlock->lineNumber, "#macro");
+      macroBlock = NULL;
+   }
+   if (errorCount == 0 || keepGoingQ) {
+      checkLabels();
+   }
+   checkOutput();
+   return errorCount == 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::getErrorCount -- returns the number of errors found.
+//
+
+int BinascCompiler::getErrorCount(void) const {
+   return errorCount;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::getErrors -- returns the list of errors found.  The
+//     list is made from the errors in the arena when it is asked for.
+//
+
+const vector<BinascError>& BinascCompiler::getErrors(void) const {
+   ErrorRecord* record = listedError == NULL ? firstError : listedError->next;
+   for ( ; record != NULL; record = record->next) {
+      BinascError newError;
+      newError.lineNumber = record->lineNumber;
+      newError.token      = record->token == NULL ? "" : record->token;
+      newError.message    = record->message;
+      errors.push_back(std::move(newError));
+      listedError = record;
+   }
+   return errors;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::getErrorRecords -- returns the first error, which
+//     links to the rest, for reading the errors without copying them.
+//     The records are valid until the compiler is cleared.
+//
+
+const ErrorRecord* BinascCompiler::getErrorRecords(void) const {
+   return firstError;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::getIncludedFiles -- returns the names of the files
+//     which were copied into the output by incbin directives.  The output
+//     depends on these files as well as on the input text.
+//
+
+const vector<string>& BinascCompiler::getIncludedFiles(void) const {
+   return includedFiles;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::usesLabels -- returns true if the input defined a label
+//     or used one in an expression.  The value of a label is an offset in
+//     the whole output, so such input cannot be compiled in pieces.
+//
+
+int BinascCompiler::usesLabels(void) const {
+   return !labelOffsets.empty() || !labelFixups.empty();
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::usesMacros -- returns true if the input defined a
+//     macro.  Later lines may use it, so such input cannot be compiled in
+//     pieces either.
+//
+
+int BinascCompiler::usesMacros(void) const {
+   return macros.getCount() > 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::getInputSize -- returns the number of bytes of text
+//     given to compileText() and compileStream() since the compiler was
+//     created or cleared.
+//
+
+ulonglong BinascCompiler::getInputSize(void) const {
+   return inputSize;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::compileBytes -- compile text into a vector of bytes
+//     with a compiler of its own.  Returns 0 if there were errors, which
+//     are stored in errors.
+//
+
+int BinascCompiler::compileBytes(const char* text, size_t length,
+      vector<uchar>& bytes, vector<BinascError>& errors) {
+   BinascCompiler compiler;
+   compiler.compileText(text, length);
+   compiler.finish();
+   const uchar* data = compiler.memoryOutput.getData();
+   bytes.assign(data, data + compiler.memoryOutput.getSize());
+   errors = compiler.getErrors();
+   return errors.empty();
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+
+//////////////////////////////
+//
+// BinascCompiler::processLine -- read a line of input and output any
+//     specified bytes.  Lines inside of a #macro block are stored in the
+//     macro instead.
+//
+
+void BinascCompiler::processLine(char* inputLine, int lineCount,
+      OutputBuffer& out) {
+   char* position = inputLine;
+   char* word = getNextWord(position);
+   if (macroBlock != NULL) {
+      addMacroLine(word, position, lineCount);
+      return;
+   }
+   if (word != NULL && word[0] == '#' &&
+         processDirective(word, position, lineCount)) {
+      return;
+   }
+   BinascMacro* macro;
+   int macrosQ = macros.getCount() > 0;
+   uchar byte;
+   while (word != NULL) {
+      if ((word[0] == ';') || (word[0] == '#')) {
+         return;
+      }
+      if (errorCount != 0 && !keepGoingQ) {
+         return;
+      }
+      if (!(macrosQ && isalpha(word[0])) && readShortHex(word, byte)) {
+         // a hexadecimal byte, unless it could be the name of a macro
+         out << byte;
+      } else if (macrosQ && (isalpha(word[0]) || word[0] == '_') &&
+            (macro = macros.find(word)) != NULL) {
+         expandMacro(*macro, position, lineCount, out);
+      } else if (word[0] != '"' && word[strlen(word) - 1] == ':') {
+         processLabel(word, lineCount, out);
+      } else if (word[0] == 'f' && strcmp(word, "fill") == 0) {
+         processFillDirective(position, lineCount, out);
+      } else if (word[0] == 'i' && strcmp(word, "incbin") == 0) {
+         if (!processIncbinDirective(position, lineCount, out)) {
+            return;
+         }
+      } else {
+         processWord(word, lineCount, out);
+      }
+      word = getNextWord(position);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::getNextWord -- return the next word on a line, starting at
+//     position, and move position past it.  Words are separated by spaces and
+//     tabs, except inside of double quotes.  Returns NULL at the end of the
+//     line.
+//
+
+char* BinascCompiler::getNextWord(char*& position) {
+   while (charClasses[(uchar)*position] == CHAR_SEPARATOR) {
+      position++;
+   }
+   if (*position == '\0') {
+      return NULL;
+   }
+   char* word = position;
+   int type;
+   while ((type = charClasses[(uchar)*position]) != CHAR_SEPARATOR &&
+         type != CHAR_END) {
+      if (type == CHAR_QUOTE) {
+         position++;
+         while (*position != '\0' && *position != '"') {
+            if (*position == '\\' && position[1] != '\0') {
+               position++;
+            }
+            position++;
+         }
+         if (*position == '\0') {
+            break;
+         }
+      }
+      position++;
+   }
+   if (*position != '\0') {
+      *position++ = '\0';
+   }
+   return word;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::openScratch -- collect the bytes of a single word in
+//     scratch memory, which the caller gives back when it is done with
+//     them.  The memory is large enough for the bytes of almost any
+//     word; the buffer moves to the heap for the rest.
+//
+
+void BinascCompiler::openScratch(OutputBuffer& bytes, const char* word) {
+   size_t size = strlen(word) + 16;
+   bytes.open((uchar*)scratchArena.allocate(size), size);
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processWord -- convert a single word into bytes.  Returns 0
+//     if the word has an error.
+//
+
+int BinascCompiler::processWord(const char* word, int lineCount,
+      OutputBuffer& out) {
+   uchar byte;
+   if (readShortHex(word, byte)) {
+      out << byte;
+      return 1;
+   }
+   int i = 0;
+   while (isdigit(word[i])) {
+      i++;
+   }
+   if (i > 0 && word[i] == '*') {
+      return processRepeatWord(word, lineCount, out);
+   } else if (word[0] == '"') {
+      return processStringWord(word, lineCount, out);
+   } else if (strncmp(word, "x'", 2) == 0) {
+      return processHexBlobWord(word, lineCount, out);
+   } else if (strncmp(word, "b64'", 4) == 0) {
+      return processBase64Word(word, lineCount, out);
+   } else if (strncmp(word, "uleb'", 5) == 0 || 
+              strncmp(word, "sleb'", 5) == 0) {
+      return processLebWord(word, lineCount, out);
+   } else if (word[0] == '+') {
+      return processAsciiWord(word, lineCount, out);
+   } else if (word[0] == 'v') {
+      return processVlvWord(word, lineCount, out);
+   } else if (word[0] == 'p') {
+      return processMidiPitchBendWord(word, lineCount, out);
+   } else if (strstr(word, "'(")) {
+      return processExpressionWord(word, lineCount, out);
+   } else if (strchr(word, '\'')) {
+      return processDecimalWord(word, lineCount, out);
+   } else if (strchr(word, ',') || strlen(word) > 2) {
+      return processBinaryWord(word, lineCount, out);
+   } else {
+      return processHexadecimalWord(word, lineCount, out);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processRepeatWord -- a decimal count followed by "*" and
+//     another word, such as "1024*00" or "16*4u'-1".  The bytes of the word
+//     are calculated once and then written count times in bulk.
+//
+
+int BinascCompiler::processRepeatWord(const char* word, int lineNumber,
+      OutputBuffer& out) {
+   char* star;
+   errno = 0;
+   ulonglong count = strtoull(word, &star, 10);
+   if (errno == ERANGE) {
+      errorText << "repeat count is too large";
+      return error(lineNumber, word);
+   }
+   if (star[1] == '\0') {
+      errorText << "there must be a word to repeat after the \'*\'";
+      return error(lineNumber, word);
+   }
+
+   if (star[1] != '"' && strstr(star + 1, "'(")) {
+      errorText << "label expressions cannot be repeated";
+      return error(lineNumber, word);
+   }
+
+   ArenaMark mark = scratchArena.getMark();
+   OutputBuffer bytes;
+   openScratch(bytes, star + 1);
+   int status = processWord(star + 1, lineNumber, bytes);
+   if (status && !out.repeat(bytes.getData(), bytes.getSize(), count)) {
+      errorText << "repeat count is too large";
+      status = error(lineNumber, word);
+   }
+   scratchArena.release(mark);
+   return status;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processFillDirective -- the words "fill N byte" write the
+//     byte N times. The count and byte are the next two words on the line.
+//     The byte can be given in any of the forms for a single byte.
+//
+
+int BinascCompiler::processFillDirective(char*& position, int lineNumber, 
+      OutputBuffer& out) {
+   char* countWord = getNextWord(position);
+   char* byteWord  = NULL;
+   if (countWord != NULL) {
+      byteWord = getNextWord(position);
+   }
+   if (countWord == NULL || byteWord == NULL || byteWord[0] == ';') {
+      errorText << "fill needs a byte count and a byte: fill N byte";
+      return error(lineNumber, NULL);
+   }
+
+   char* ending;
+   errno = 0;
+   ulonglong count = strtoull(countWord, &ending, 10);
+   if (!isdigit(countWord[0]) || *ending != '\0') {
+      errorText << "fill count must be a decimal number";
+      return error(lineNumber, countWord);
+   }
+   if (errno == ERANGE) {
+      errorText << "fill count is too large";
+      return error(lineNumber, countWord);
+   }
+
+   ArenaMark mark = scratchArena.getMark();
+   OutputBuffer bytes;
+   openScratch(bytes, byteWord);
+   int status = 1;
+   if (byteWord[0] == '"' || !strstr(byteWord, "'(")) {
+      status = processWord(byteWord, lineNumber, bytes);
+   }
+   if (status && bytes.getSize() != 1) {
+      errorText << "fill value must be a single byte";
+      status = error(lineNumber, byteWord);
+   }
+   if (status) {
+      out.fill(bytes.getData()[0], count);
+   }
+   scratchArena.release(mark);
+   return status;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processLabel -- a word ending in a colon, such as "start:",
+//     marks the current output offset.  Expressions waiting for the label are
+//     filled in once all of their labels are known.
+//
+
+int BinascCompiler::processLabel(const char* word, int lineNumber,
+      OutputBuffer& out) {
+   int length = strlen(word);
+   string name(word, length - 1);
+   int i;
+   if (!validName(word, length - 1)) {
+      errorText << "label names must start with a letter and contain only "
+                << "letters, digits and underscores";
+      return error(lineNumber, word);
+   }
+   if (labelOffsets.find(name) != labelOffsets.end()) {
+      errorText << "label " << name << " is already defined";
+      return error(lineNumber, word);
+   }
+   labelOffsets[name] = out.tell();
+
+   map<string, vector<int> >::iterator waiting = labelWaiting.find(name);
+   if (waiting == labelWaiting.end()) {
+      return 1;
+   }
+   for (i=0; i<(int)waiting->second.size(); i++) {
+      LabelFixup& fixup = labelFixups[waiting->second[i]];
+      if (--fixup.unresolved == 0) {
+         writeFixup(fixup, out);
+         out.release(fixup.offset);
+      }
+   }
+   labelWaiting.erase(waiting);
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::validName -- returns true if a name starts with a
+//     letter or underscore and contains only letters, digits and
+//     underscores.  Labels, macros and macro parameters are named this way.
+//
+
+int BinascCompiler::validName(const char* name, size_t length) {
+   if (length == 0 || !(isalpha(name[0]) || name[0] == '_')) {
+      return 0;
+   }
+   for (size_t i=1; i<length; i++) {
+      if (!(isalnum(name[i]) || name[i] == '_')) {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processDirective -- a line starting with "#define NAME"
+//     defines a macro which stands for the rest of the line, and a line
+//     starting with "#macro NAME" followed by parameter names starts a
+//     macro block which ends at a line starting with "#endmacro".  Returns
+//     0 if the word is not a directive, in which case the line is a
+//     comment.
+//
+
+int BinascCompiler::processDirective(const char* word, char*& position,
+      int lineNumber) {
+   int blockQ = strcmp(word, "#macro") == 0;
+   if (strcmp(word, "#endmacro") == 0) {
+      errorText << "#endmacro without #macro";
+      error(lineNumber, word);
+      return 1;
+   }
+   if (!blockQ && strcmp(word, "#define") != 0) {
+      return 0;
+   }
+
+   const char* name = getNextWord(position);
+   if (name == NULL || name[0] == ';') {
+      errorText << word << " needs a macro name";
+      error(lineNumber, word);
+      return 1;
+   }
+   if (!validName(name, strlen(name))) {
+      errorText << "macro names must start with a letter and contain only "
+                << "letters, digits and underscores";
+      error(lineNumber, name);
+      return 1;
+   }
+   if (strcmp(name, "fill") == 0 || strcmp(name, "incbin") == 0) {
+      errorText << name << " is a directive and cannot be a macro name";
+      error(lineNumber, name);
+      return 1;
+   }
+   BinascMacro* macro = macros.define(name, lineNumber);
+   if (macro == NULL) {
+      errorText << "macro " << name << " is already defined";
+      error(lineNumber, name);
+      return 1;
+   }
+
+   const char* item;
+   while ((item = getNextWord(position)) != NULL && item[0] != ';' &&
+         item[0] != '#') {
+      if (!blockQ) {
+         macros.addWord(*macro, item);
+      } else if (!validName(item, strlen(item))) {
+         errorText << "parameter names must start with a letter and "
+                   << "contain only letters, digits and underscores";
+         error(lineNumber, item);
+      } else if (!macros.addParameter(*macro, item)) {
+         errorText << "parameter " << item << " is given twice";
+         error(lineNumber, item);
+      }
+   }
+   if (blockQ) {
+      macroBlock = macro;
+   } else {
+      macros.endLine(*macro);
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::addMacroLine -- store a line of a #macro block in the
+//     macro, without its comment.  Blank lines are dropped.
+//
+
+void BinascCompiler::addMacroLine(const char* word, char*& position,
+      int lineNumber) {
+   if (word == NULL) {
+      return;
+   }
+   if (strcmp(word, "#endmacro") == 0) {
+      macroBlock = NULL;
+      return;
+   }
+   if (strcmp(word, "#macro") == 0 || strcmp(word, "#define") == 0) {
+      errorText << "macros cannot be defined inside of macro "
+                << macroBlock->name;
+      error(lineNumber, word);
+      return;
+   }
+   if (word[0] == ';' || word[0] == '#') {
+      return;
+   }
+   while (word != NULL && word[0] != ';' && word[0] != '#') {
+      macros.addWord(*macroBlock, word);
+      word = getNextWord(position);
+   }
+   macros.endLine(*macroBlock);
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::expandMacro -- compile the lines of a macro, with each
+//     parameter replaced by one of the words following the macro's name.
+//     Each line is put together in scratch memory from the stored words,
+//     so the time taken is proportional to the size of the expansion.
+//     Returns 0 if there was an error.
+//
+
+int BinascCompiler::expandMacro(BinascMacro& macro, char*& position,
+      int lineNumber, OutputBuffer& out) {
+   if (macro.activeQ) {
+      errorText << "macro " << macro.name << " is used inside of itself";
+      return error(lineNumber, macro.name);
+   }
+   ArenaMark mark = scratchArena.getMark();
+   int count = (int)macro.parameters.size();
+   const char** arguments = (const char**)scratchArena.allocate(
+         count * sizeof(const char*));
+   size_t* lengths = (size_t*)scratchArena.allocate(count * sizeof(size_t));
+   for (int i=0; i<count; i++) {
+      const char* argument = getNextWord(position);
+      if (argument == NULL || argument[0] == ';' || argument[0] == '#') {
+         scratchArena.release(mark);
+         position += strlen(position);
+         errorText << "macro " << macro.name << " needs " << count
+                   << (count == 1 ? " word" : " words") << " after it";
+         return error(lineNumber, macro.name);
+      }
+      arguments[i] = argument;
+      lengths[i]   = strlen(argument);
+   }
+
+   const vector<MacroWord>& body = macro.body;
+   macro.activeQ = 1;
+   size_t start = 0;
+   while (start < body.size()) {
+      size_t end;
+      size_t length = 1;
+      for (end=start; body[end].text != NULL || body[end].parameter >= 0;
+            end++) {
+         length += 1 + (body[end].text != NULL ? body[end].length :
+               lengths[body[end].parameter]);
+      }
+      ArenaMark lineMark = scratchArena.getMark();
+      char* line = (char*)scratchArena.allocate(length);
+      char* ptr = line;
+      for (size_t i=start; i<end; i++) {
+         const char* text = body[i].text;
+         size_t size = body[i].length;
+         if (text == NULL) {
+            text = arguments[body[i].parameter];
+            size = lengths[body[i].parameter];
+         }
+         memcpy(ptr, text, size);
+         ptr += size;
+         *ptr++ = ' ';
+      }
+      *ptr = '\0';
+      processLine(line, lineNumber, out);
+      scratchArena.release(lineMark);
+      if (errorCount != 0 && !keepGoingQ) {
+         break;
+      }
+      start = end + 1;
+   }
+   macro.activeQ = 0;
+   scratchArena.release(mark);
+   return errorCount == 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processExpressionWord -- a decimal word whose value is a
+//     parenthesized sum of labels and numbers, such as 4'(end-start) or
+//     2u'(end-start+2). If any of the labels are not defined yet, the bytes
+//     are reserved and filled in later.
+//
+
+int BinascCompiler::processExpressionWord(const char* word, int lineNumber, 
+      OutputBuffer& out) {
+   LabelFixup fixup;
+   if (!parseExpression(word, lineNumber, fixup)) {
+      return 0;
+   }
+   fixup.offset     = out.tell();
+   fixup.lineNumber = lineNumber;
+   fixup.word       = word;
+   fixup.unresolved = 0;
+
+   int i;
+   for (i=0; i<(int)fixup.names.size(); i++) {
+      if (labelOffsets.find(fixup.names[i]) == labelOffsets.end()) {
+         labelWaiting[fixup.names[i]].push_back(labelFixups.size());
+         fixup.unresolved++;
+      }
+   }
+
+   out.fill(0, fixup.byteCount);
+   if (fixup.unresolved == 0) {
+      writeFixup(fixup, out);
+   } else {
+      out.hold(fixup.offset);
+      labelFixups.push_back(fixup);
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::parseExpression -- read the byte count, endian marker and
+//     terms of an expression word.
+//
+
+int BinascCompiler::parseExpression(const char* word, int lineNumber,
+      LabelFixup& fixup) {
+   fixup.byteCount = 1;
+   fixup.littleQ   = 0;
+   fixup.constant  = 0;
+   const char* ptr = word;
+   while (*ptr != '\'') {
+      if (*ptr >= '1' && *ptr <= '8') {
+         fixup.byteCount = *ptr - '0';
+      } else if (*ptr == 'u' || *ptr == 'U') {
+         fixup.littleQ = 1;
+      } else {
+         errorText << "invalid byte count or endian marker before quote";
+         return error(lineNumber, word);
+      }
+      ptr++;
+   }
+   ptr += 2;   // skip quote and opening parenthesis
+
+   int sign = 1;
+   int termQ = 0;   // expecting an operator after a term
+   while (*ptr != ')') {
+      if (termQ && (*ptr == '+' || *ptr == '-')) {
+         sign = *ptr == '-' ? -1 : 1;
+         termQ = 0;
+         ptr++;
+      } else if (!termQ && isdigit(*ptr)) {
+         char* ending;
+         errno = 0;
+         ulonglong term = strtoull(ptr, &ending, 10);
+         if (errno == ERANGE || term > (ulonglong)LLONG_MAX ||
+               __builtin_add_overflow(fixup.constant,
+               sign * (long long)term, &fixup.constant)) {
+            errorText << "number in expression is too large";
+            return error(lineNumber, word);
+         }
+         ptr = ending;
+         termQ = 1;
+      } else if (!termQ && (isalpha(*ptr) || *ptr == '_')) {
+         const char* start = ptr;
+         while (isalnum(*ptr) || *ptr == '_') {
+            ptr++;
+         }
+         fixup.names.push_back(string(start, ptr - start));
+         fixup.signs.push_back(sign);
+         termQ = 1;
+      } else if (!termQ && *ptr == '-' && sign == 1 && ptr[-1] == '(') {
+         sign = -1;
+         ptr++;
+      } else {
+         errorText << "invalid expression: use labels and numbers joined "
+                   << "with + or -";
+         return error(lineNumber, word);
+      }
+   }
+   if (!termQ || ptr[1] != '\0') {
+      errorText << "expression must end with a term and a closing parenthesis";
+      return error(lineNumber, word);
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::writeFixup -- calculate the value of an expression whose
+//     labels are all defined and write it into its reserved bytes.
+//
+
+void BinascCompiler::writeFixup(LabelFixup& fixup, OutputBuffer& out) {
+   long long value = fixup.constant;
+   int i;
+   for (i=0; i<(int)fixup.names.size(); i++) {
+      if (__builtin_add_overflow(value,
+            fixup.signs[i] * (long long)labelOffsets[fixup.names[i]],
+            &value)) {
+         errorText << "value of expression is too large";
+         error(fixup.lineNumber, fixup.word.c_str());
+         return;
+      }
+   }
+
+   if (fixup.byteCount < 8) {
+      long long limit = 1LL << (8 * fixup.byteCount);
+      if (value >= limit || value < -(limit / 2)) {
+         errorText << "value " << value << " does not fit into " 
+                   << fixup.byteCount << " bytes";
+         error(fixup.lineNumber, fixup.word.c_str());
+         return;
+      }
+   }
+
+   uchar bytes[8];
+   int type = value < 0 ? NUMBER_SIGNED : NUMBER_UNSIGNED;
+   numberEncoders[getNumberDescriptor(fixup.byteCount, fixup.littleQ, type)]
+         ((ulonglong)value, bytes);
+   out.patch(fixup.offset, bytes, fixup.byteCount);
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::checkLabels -- report any expressions which refer to
+//     labels that were never defined.  Each label is reported at its first
+//     use, in the order of the input like other errors.
+//
+
+void BinascCompiler::checkLabels(void) {
+   vector<pair<int, string> > undefined;
+   map<string, vector<int> >::iterator it;
+   for (it = labelWaiting.begin(); it != labelWaiting.end(); it++) {
+      undefined.push_back(make_pair(it->second[0], it->first));
+   }
+   // fixups are numbered in the order of the input
+   sort(undefined.begin(), undefined.end());
+   for (int i=0; i<(int)undefined.size(); i++) {
+      LabelFixup& fixup = labelFixups[undefined[i].first];
+      errorText << "label " << undefined[i].second << " is never defined";
+      error(fixup.lineNumber, fixup.word.c_str());
+   }
+   labelWaiting.clear();
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::error -- add the message in errorText to the list of
+//     errors.  Returns 0 for the caller to return.
+//
+
+int BinascCompiler::error(int lineNumber, const char* token) {
+   ErrorRecord* record = (ErrorRecord*)errorArena.allocate(
+         sizeof(ErrorRecord));
+   record->lineNumber = lineNumber;
+   record->token      = token == NULL ? NULL : errorArena.copy(token);
+   record->message    = errorArena.copy(messageBuffer.getText());
+   record->next       = NULL;
+   if (lastError == NULL) {
+      firstError = record;
+   } else {
+      lastError->next = record;
+   }
+   lastError = record;
+   errorCount++;
+   messageBuffer.clear();
+   return 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::checkOutput -- report the first problem with writing
+//     the output as an error.
+//
+
+void BinascCompiler::checkOutput(void) {
+   if (outputErrorQ || output->good()) {
+      return;
+   }
+   errorText << output->getError();
+   error(lineNumber, NULL);
+   outputErrorQ = 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processIncbinDirective -- the words "incbin file [offset
+//     [length]]" copy the bytes of another file into the output.  The
+//     optional offset and length are decimal byte counts; by default the
+//     whole file is copied.  Returns 0 if a comment ended the directive, so
+//     that the rest of the line is skipped.
+//
+
+int BinascCompiler::processIncbinDirective(char*& position, int lineNumber, 
+      OutputBuffer& out) {
+   char* filename = getNextWord(position);
+   if (filename == NULL || filename[0] == ';') {
+      errorText << "incbin needs a file name: incbin file [offset [length]]";
+      return error(lineNumber, NULL);
+   }
+
+   ulonglong values[2] = {0, 0};
+   int valueCount = 0;
+   int continueQ = 1;
+   char* word;
+   while (valueCount < 2 && (word = getNextWord(position)) != NULL) {
+      if (word[0] == ';') {
+         continueQ = 0;
+         break;
+      }
+      char* ending;
+      values[valueCount] = strtoull(word, &ending, 10);
+      if (!isdigit(word[0]) || *ending != '\0') {
+         errorText << "incbin offset and length must be decimal numbers";
+         return error(lineNumber, word);
+      }
+      valueCount++;
+   }
+
+   int infd = open(filename, O_RDONLY);
+   struct stat info;
+   if (infd < 0 || fstat(infd, &info) != 0) {
+      errorText << "cannot read incbin file " << filename << ": " 
+                << strerror(errno);
+      if (infd >= 0) {
+         close(infd);
+      }
+      return error(lineNumber, NULL);
+   }
+
+   // from here on, infd is closed at the end whatever happens
+   int status = continueQ;
+   ulonglong filesize = (ulonglong)info.st_size;
+   ulonglong offset   = values[0];
+   ulonglong length   = filesize - offset;
+   if (valueCount > 1) {
+      length = values[1];
+   }
+   if (offset > filesize || length > filesize - offset) {
+      errorText << "incbin range is past the end of " << filename 
+                << " (" << filesize << " bytes)";
+      status = error(lineNumber, NULL);
+   } else {
+      includedFiles.push_back(filename);
+      if (!out.copyFrom(infd, offset, length)) {
+         errorText << "error reading incbin file " << filename;
+         status = error(lineNumber, NULL);
+      }
+   }
+   close(infd);
+   return status;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processMidiPitchBendWord -- convert a floating point number
+//    in the range from +1.0 to -1.0 into a 14-point integer with -1.0 mapping
+//    to 0 and +1.0 mapping to 2^15-1.  This integer will be packed into two
+//    bytes, with the LSB coming first and containing the bottom 7-bits of the
+//    14-bit value, then the MSB coming second and containing the top 7-bits
+//    of the 14-bit value.
+//
+
+int BinascCompiler::processMidiPitchBendWord(const char* word, int lineNumber,
+      OutputBuffer& out) {
+   if (strlen(word) < 2) {
+      errorText << "'p' needs to be followed immediately by "
+                << "a floating-point number";
+      return error(lineNumber, word);
+   }
+   if (!(isdigit(word[1]) || word[1] == '.' || word[1] == '-' 
+         || word[1] == '+')) {
+      errorText << "'p' needs to be followed immediately by "
+                << "a floating-point number";
+      return error(lineNumber, word);
+   }
+   double value = strtod(&word[1], NULL);
+
+   if (value > 1.0) {
+      value = 1.0;
+   }
+   if (value < -1.0) {
+      value = -1.0;
+   }
+
+   int intval = (int)(((1 << 13)-0.5)  * (value + 1.0) + 0.5);
+   uchar LSB = intval & 0x7f;
+   uchar MSB = (intval >>  7) & 0x7f;
+   out << LSB << MSB;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processVlvWord -- print a number in Variable Length Value
+//   form. The number is split into 7-bit groupings, the MSB's that are zero
+//   are dropped.  A continuation bit is added as the MSbit to each 7-bit
+//   grouping. The continuation bit is "1" if there is another byte in the
+//   VLV; "0" for the last byte.  VLVs are always big-endian.  The input word
+//   starts with the character "v" followed without space by an integer of up
+//   to 64 bits.
+//
+
+int BinascCompiler::processVlvWord(const char* word, int lineNumber,
+      OutputBuffer& out) {
+
+   if (!isdigit(word[1])) {
+      errorText << "'v' needs to be followed immediately by a decimal digit";
+      return error(lineNumber, word);
+   }
+   ulonglong value = 0;
+   const char* ending = word + strlen(word);
+   from_chars_result result = from_chars(word + 1, ending, value);
+   if (result.ec == errc::result_out_of_range || result.ptr != ending) {
+      errorText << "VLV must be a decimal number from 0 to "
+                << "18446744073709551615";
+      return error(lineNumber, word);
+   }
+
+   uchar bytes[10];
+   out.write(bytes, encodeVlv(value, bytes));
+   return 1;
+}
+            
+
+
+//////////////////////////////
+//
+// BinascCompiler::processLebWord -- print a number in LEB128 form, as used by
+//   DWARF, WebAssembly and protocol buffers.  Like a VLV, the number is split
+//   into 7-bit groups with continuation bits, but the least significant group
+//   comes first.  uleb' is followed by an unsigned number, and sleb' by a
+//   number which may be negative, where the top bit of the last group is the
+//   sign.  Examples: uleb'624485 sleb'-123456
+//
+
+int BinascCompiler::processLebWord(const char* word, int lineNumber,
+      OutputBuffer& out) {
+   int signedQ = word[0] == 's';
+   const char* digits = word + 5;
+   const char* ending = word + strlen(word);
+   int signQ = 0;
+   if (signedQ && *digits == '-') {
+      signQ = 1;
+      digits++;
+   }
+
+   ulonglong magnitude = 0;
+   from_chars_result result = from_chars(digits, ending, magnitude);
+   if (digits == ending || result.ptr != ending) {
+      errorText << "LEB128 number must be a decimal integer";
+      return error(lineNumber, word);
+   }
+   if (result.ec == errc::result_out_of_range || 
+         (signedQ && magnitude > (1ULL << 63) - 1 + signQ)) {
+      errorText << "LEB128 number is too large to fit into 8 bytes";
+      return error(lineNumber, word);
+   }
+
+   uchar bytes[10];
+   int count;
+   if (signedQ) {
+      count = encodeSleb128(signQ ? (longlong)(0 - magnitude) : 
+            (longlong)magnitude, bytes);
+   } else {
+      count = encodeUleb128(magnitude, bytes);
+   }
+   out.write(bytes, count);
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processDecimalWord -- interprets a decimal word into
+//     constituent bytes.  The word is checked and parsed in a single
+//     pass: an optional byte count (1-8) and endian marker (u), a quote,
+//     an optional minus sign, and then the digits of the number, which
+//     are converted with from_chars.
+//
+
+int BinascCompiler::processDecimalWord(const char* word, int lineNumber,
+      OutputBuffer& out) {
+   int byteCount = -1;              // number of bytes to output
+   int littleQ   = 0;               // write bytes in little-endian order
+   int signQ     = 0;               // number has a minus sign
+   int floatQ    = 0;               // number has a decimal point
+   const char* ptr = word;
+
+   // byte count and endian marker before the quote
+   for ( ; *ptr != '\''; ptr++) {
+      if (*ptr >= '1' && *ptr <= '8' && byteCount == -1) {
+         byteCount = *ptr - '0';
+      } else if ((*ptr == 'u' || *ptr == 'U') && !littleQ) {
+         littleQ = 1;
+      } else {
+         errorText << "invalid byte specificaton before quote in "
+                   << "decimal number";
+         return error(lineNumber, word);
+      }
+   }
+
+   const char* number = ++ptr;     // number including any sign
+   if (*ptr == '-') {
+      signQ = 1;
+      ptr++;
+   }
+   const char* digits = ptr;       // number without the sign
+   for ( ; *ptr != '\0'; ptr++) {
+      if (*ptr == '.' && !floatQ) {
+         floatQ = 1;
+      } else if (!isdigit(*ptr)) {
+         errorText << "Invalid character in decimal number"
+                      " (character number " << (ptr - word) << ")";
+         return error(lineNumber, word);
+      }
+   }
+   const char* ending = ptr;
+   if (ending == digits || (floatQ && ending - digits == 1)) {
+      errorText << "there must be a decimal number after the quote";
+      return error(lineNumber, word);
+   }
+
+   ulonglong value = 0;            // integer, or bits of a double
+   int type;
+   if (floatQ) {
+      // default size for floating point numbers is 4 bytes
+      if (byteCount == -1) {
+         byteCount = 4;
+      }
+      double doubleOutput = 0.0;
+      from_chars(number, ending, doubleOutput);
+      memcpy(&value, &doubleOutput, 8);
+      type = NUMBER_FLOAT;
+   } else {
+      ulonglong magnitude = 0;
+      from_chars_result result = from_chars(digits, ending, magnitude);
+      if (result.ec == errc::result_out_of_range ||
+            (signQ && magnitude > (1ULL << 63))) {
+         errorText << "Decimal number is too large to fit into 8 bytes";
+         return error(lineNumber, word);
+      }
+      value = signQ ? 0 - magnitude : magnitude;
+      type  = signQ ? NUMBER_SIGNED : NUMBER_UNSIGNED;
+
+      // default integer size is one byte, if size is not specified, then
+      // the number must be in the one byte range and cannot overflow
+      // the byte if the size of the decimal number is not specified
+      if (byteCount == -1) {
+         if (signQ && magnitude > 128) {
+            errorText << "Decimal number out of range from -128 to 127";
+            return error(lineNumber, word);
+         } else if (!signQ && magnitude > 255) {
+            errorText << "Decimal number out of range from 0 to 255";
+            return error(lineNumber, word);
+         }
+         byteCount = 1;
+      }
+   }
+
+   // a specified byte count keeps the lowest bytes of an integer
+   NumberEncoder encoder = 
+         numberEncoders[getNumberDescriptor(byteCount, littleQ, type)];
+   if (encoder == NULL) {
+      errorText << "floating-point numbers can be only 4 or 8 bytes";
+      return error(lineNumber, word);
+   }
+   encoder(value, out.reserve(byteCount));
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processHexadecimalWord -- interprets a hexadecimal word into
+//     its constituent byte
+//
+
+int BinascCompiler::processHexadecimalWord(const char* word, int lineNumber,
+      OutputBuffer& out) {
+   int length = strlen(word);
+   uchar outputByte;
+
+   if (length > 2) {
+      errorText << "Size of hexadecimal number is too large.  Max is ff.";
+      return error(lineNumber, word);
+   }
+
+   if (!isxdigit(word[0]) || (length == 2 && !isxdigit(word[1]))) {
+      errorText << "Invalid character in hexadecimal number.";
+      return error(lineNumber, word);
+   }
+   
+   outputByte = (uchar)strtol(word, (char**)NULL, 16);
+   out << outputByte;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processStringWord -- write the characters of a string in
+//     double quotes. Backslash escapes are \n, \r, \t, \0, \\, \" and \xHH;
+//     the text between escapes is copied to the output as a block.
+//
+
+int BinascCompiler::processStringWord(const char* word, int lineNumber,
+      OutputBuffer& out) {
+   int length = strlen(word);
+   if (length < 2 || word[length - 1] != '"') {
+      errorText << "string is missing its closing double quote";
+      return error(lineNumber, word);
+   }
+
+   const char* start = word + 1;
+   const char* end   = word + length - 1;
+   const char* ptr;
+   while ((ptr = (const char*)memchr(start, '\\', end - start)) != NULL) {
+      if (ptr + 1 == end) {
+         errorText << "string is missing its closing double quote";
+         return error(lineNumber, word);
+      }
+      out.write(start, ptr - start);
+      uchar value;
+      switch (ptr[1]) {
+         case 'n':  value = '\n'; break;
+         case 'r':  value = '\r'; break;
+         case 't':  value = '\t'; break;
+         case '0':  value = '\0'; break;
+         case '\\': value = '\\'; break;
+         case '"':  value = '"';  break;
+         case 'x':
+            if (ptr + 3 < end && isxdigit(ptr[2]) && isxdigit(ptr[3])) {
+               char digits[3] = {ptr[2], ptr[3], '\0'};
+               value = (uchar)strtol(digits, NULL, 16);
+               ptr += 2;
+               break;
+            }
+            // fall through
+         default:
+            errorText << "invalid escape sequence in string";
+            return error(lineNumber, word);
+      }
+      out << value;
+      start = ptr + 2;
+   }
+   if (start < end) {
+      out.write(start, end - start);
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processHexBlobWord -- any number of bytes given as
+//     hexadecimal digits between x' and ', such as x'deadbeef'.  The digits
+//     are decoded directly into the output buffer.
+//
+
+int BinascCompiler::processHexBlobWord(const char* word, int lineNumber,
+      OutputBuffer& out) {
+   int length = strlen(word);
+   if (length < 3 || word[length - 1] != '\'') {
+      errorText << "hexadecimal bytes must end with a quote: x'0123abcd'";
+      return error(lineNumber, word);
+   }
+   int digits = length - 3;
+   if (digits % 2) {
+      errorText << "hexadecimal bytes need an even number of digits";
+      return error(lineNumber, word);
+   }
+   if (!decodeHex(word + 2, digits, out.reserve(digits / 2))) {
+      errorText << "Invalid character in hexadecimal bytes.";
+      return error(lineNumber, word);
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processBase64Word -- bytes given in base64 between b64' and
+//     ', such as b64'TVRoZA=='.  The text is decoded directly into the output
+//     buffer.
+//
+
+int BinascCompiler::processBase64Word(const char* word, int lineNumber,
+      OutputBuffer& out) {
+   int length = strlen(word);
+   if (length < 5 || word[length - 1] != '\'') {
+      errorText << "base64 bytes must end with a quote: b64'TVRoZA=='";
+      return error(lineNumber, word);
+   }
+   const char* text = word + 4;
+   int textLength = length - 5;
+   size_t size = getBase64DecodedSize(text, textLength);
+   if (!decodeBase64(text, textLength, out.reserve(size))) {
+      errorText << "Invalid base64 bytes.";
+      return error(lineNumber, word);
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processAsciiWord -- interprets a binary word into
+//     its constituent byte
+//
+
+int BinascCompiler::processAsciiWord(const char* word, int lineNumber,
+      OutputBuffer& out) {
+   int length = strlen(word);
+   uchar outputByte;
+  
+   if (word[0] != '+') {
+      errorText << "character byte must start with \'+\' sign: ";
+      return error(lineNumber, word);
+   }
+
+   if (length > 2) {
+      errorText << "character byte word is too long -- "
+                << "specify only one character";
+      return error(lineNumber, word);
+   }
+
+   if (length == 2) {
+      outputByte = (uchar)word[1];
+   } else {
+      outputByte = ' ';
+   }
+   out << outputByte;
+   return 1;
+}
+  
+
+
+
+//////////////////////////////
+//
+// BinascCompiler::processBinaryWord -- interprets a binary word into
+//     its constituent byte
+//
+
+int BinascCompiler::processBinaryWord(const char* word, int lineNumber,
+      OutputBuffer& out) {
+   int length = strlen(word);       // length of ascii binary number
+   int commaIndex = -1;             // index location of comma in number
+   int leftDigits = -1;             // number of digits to left of comma
+   int rightDigits = -1;            // number of digits to right of comma
+   int i = 0;
+
+   // make sure that all characters are valid
+   for (i=0; i<length; i++) {
+      if (word [i] == ',') {
+         if (commaIndex != -1) {
+            errorText << "extra comma in binary number";
+            return error(lineNumber, word);
+         } else {
+            commaIndex = i;
+         }
+      } else if (!(word[i] == '1' || word[i] == '0')) {
+         errorText << "Invalid character in binary number"
+                      " (character is " << word[i] <<")";
+         return error(lineNumber, word);
+      }
+   }
+
+   // comma cannot start or end number
+   if (commaIndex == 0) {
+      errorText << "cannot start binary number with a comma";
+      return error(lineNumber, word);
+   } else if (commaIndex == length - 1 ) {
+      errorText << "cannot end binary number with a comma";
+      return error(lineNumber, word);
+   }
+
+   // figure out how many digits there are in binary number 
+   // number must be able to fit into one byte.
+   if (commaIndex != -1) {
+      leftDigits = commaIndex;
+      rightDigits = length - commaIndex - 1;
+   } else if (length > 8) {
+      errorText << "too many digits in binary number";
+      return error(lineNumber, word);
+   }
+   // if there is a comma, then there cannot be more than 4 digits on a side
+   if (leftDigits > 4) {
+      errorText << "too many digits to left of comma";
+      return error(lineNumber, word);
+   }
+   if (rightDigits > 4) {
+      errorText << "too many digits to right of comma";
+      return error(lineNumber, word);
+   }
+
+   // OK, we have a valid binary number, so calculate the byte
+   
+   uchar output;
+   
+   // if no comma in binary number
+   if (commaIndex == -1) {
+      for (i=0; i<length; i++) {
+         output = output << 1;
+         output |= word[i] - '0';
+      }
+   } 
+   // if comma in binary number
+   else {
+      for (i=0; i<leftDigits; i++) {
+         output = output << 1;
+         output |= word[i] - '0';
+      }
+      output = output << (4-rightDigits);
+      for (i=0+commaIndex+1; i<rightDigits+commaIndex+1; i++) {
+         output = output << 1;
+         output |= word[i] - '0';
+      }
+   }
+
+   // send the byte to the output
+   out << output;
+   return 1;
+}
+         
+
+
+
@@ -0,0 +1,208 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 18:05:12 PDT 2026
+// Last Modified: Sun Oct 18 18:05:12 PDT 2026
+// Last Modified: Sun Oct 18 21:17:45 PDT 2026 Added getIncludedFiles()
+// Last Modified: Sun Oct 18 22:03:26 PDT 2026 Added usesLabels()
+// Last Modified: Sun Oct 18 23:46:15 PDT 2026 Added setListing()
+// Last Modified: Mon Oct 19 00:31:20 PDT 2026 Arena for words and errors
+// Last Modified: Mon Oct 19 01:14:38 PDT 2026 Added #define and #macro
+// Filename:      ...binasc/BinascCompiler.h
+// Syntax:        C++
+//
+// Description:   Compiles binasc text into bytes.  All of the state for a
+//                compilation is kept in the object, so that a program can
+//                run any number of compilations without starting binasc.
+//                Errors are collected in a list rather than printed, and
+//                the bytes go into an OutputBuffer, which can be memory,
+//                a file, or a function supplied by the caller.  Words are
+//                split in place in the line, and working storage and
+//                errors come from arenas, so that steady compiling does
+//                not use the heap.
+//
+
+#ifndef _BINASCCOMPILER_H_INCLUDED
+#define _BINASCCOMPILER_H_INCLUDED
+
+#include "OutputBuffer.h"
+#include "BinascListing.h"
+#include "BinascArena.h"
+#include "BinascMacros.h"
+
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <map>
+
+
+// A BinascError is an error in the input text.
+class BinascError {
+   public:
+      int            lineNumber;  // line of the error (0 = after the input)
+      std::string    token;       // word with the error, or empty
+      std::string    message;     // description of the error
+};
+
+
+// An ErrorRecord is an error kept in the compiler's arena until the
+// list of errors is asked for.
+class ErrorRecord {
+   public:
+      int            lineNumber;  // line of the error (0 = after the input)
+      const char*    token;       // word with the error, or NULL
+      const char*    message;     // description of the error
+      ErrorRecord*   next;        // following error, or NULL
+};
+
+
+// Longest error message; the rest of a longer message is dropped.
+#define MESSAGE_SIZE 512
+
+// A MessageBuffer holds the text of the next error message in a fixed
+// array, so that messages are put together without using the heap.
+class MessageBuffer : public std::streambuf {
+   public:
+                     MessageBuffer         (void);
+      const char*    getText               (void);
+      void           clear                 (void);
+
+   protected:
+      char           text[MESSAGE_SIZE];   // message, with room for a null
+
+      int            overflow              (int character);
+};
+
+
+// A LabelFixup is an expression such as 4'(end-start) which refers to
+// labels that have not been defined yet.  Its bytes are reserved in the
+// output and filled in when the last label in the expression is defined.
+class LabelFixup {
+   public:
+      ulonglong      offset;      // location of the reserved bytes
+      int            byteCount;   // number of reserved bytes
+      int            littleQ;     // write the bytes in little-endian order
+      long long      constant;    // sum of the numbers in the expression
+      std::vector<std::string> names; // labels in the expression
+      std::vector<int> signs;     // +1 or -1 for each label
+      int            unresolved;  // number of labels not defined yet
+      int            lineNumber;  // line of the expression in the source
+      std::string    word;        // the expression, for error messages
+};
+
+
+class BinascCompiler {
+   public:
+                     BinascCompiler        (void);
+                    ~BinascCompiler        ();
+
+      void           setOutput             (OutputBuffer& out);
+      OutputBuffer&  getOutput             (void);
+      void           setKeepGoing          (int state = 1);
+      void           setListing            (BinascListing* listing);
+      void           clear                 (void);
+
+      int            compileLine           (char* line);
+      int            compileText           (const char* text, size_t length);
+      int            compileStream         (std::istream& input);
+      int            finish                (void);
+
+      int            getErrorCount         (void) const;
+      const std::vector<BinascError>& getErrors (void) const;
+      const ErrorRecord* getErrorRecords   (void) const;
+      const std::vector<std::string>& getIncludedFiles (void) const;
+      int            usesLabels            (void) const;
+      int            usesMacros            (void) const;
+      ulonglong      getInputSize          (void) const;
+
+      static int     compileBytes          (const char* text, size_t length,
+                                            std::vector<uchar>& bytes,
+                                            std::vector<BinascError>& errors);
+
+   protected:
+      OutputBuffer   memoryOutput; // output if none has been set
+      OutputBuffer*  output;       // where the compiled bytes go
+      BinascListing* listing;      // record of the bytes of each line
+      int            lineNumber;   // current line of the input
+      ulonglong      inputSize;    // bytes of text compiled
+      int            keepGoingQ;   // continue after errors
+      int            outputErrorQ; // an output error has been reported
+      BinascArena    errorArena;   // storage for errors
+      BinascArena    scratchArena; // storage while compiling a word
+      ErrorRecord*   firstError;   // errors found so far
+      ErrorRecord*   lastError;    // last error found, or NULL
+      int            errorCount;   // number of errors found
+      mutable std::vector<BinascError> errors; // list for getErrors()
+      mutable ErrorRecord* listedError; // last error in the list
+      MessageBuffer  messageBuffer; // text of the next error
+      std::ostream   errorText;    // message for the next error
+      std::vector<std::string> includedFiles; // files read by incbin
+
+      std::map<std::string, ulonglong> labelOffsets; // offsets of labels
+      std::vector<LabelFixup> labelFixups; // expressions waiting for labels
+      std::map<std::string, std::vector<int> > labelWaiting; // by label
+
+      BinascMacros   macros;       // macros defined so far
+      BinascMacro*   macroBlock;   // #macro being read, or NULL
+
+      void           processLine           (char* inputLine, int lineCount,
+                                            OutputBuffer& out);
+      static char*   getNextWord           (char*& position);
+      void           openScratch           (OutputBuffer& bytes,
+                                            const char* word);
+      int            processWord           (const char* word, int lineNumber,
+                                            OutputBuffer& out);
+      int            processRepeatWord     (const char* word, int lineNumber,
+                                            OutputBuffer& out);
+      int            processFillDirective  (char*& position, int lineNumber,
+                                            OutputBuffer& out);
+      int            processIncbinDirective(char*& position, int lineNumber,
+                                            OutputBuffer& out);
+      int            processLabel          (const char* word, int lineNumber,
+                                            OutputBuffer& out);
+      int            processDirective      (const char* word, char*& position,
+                                            int lineNumber);
+      void           addMacroLine          (const char* word, char*& position,
+                                            int lineNumber);
+      int            expandMacro           (BinascMacro& macro,
+                                            char*& position, int lineNumber,
+                                            OutputBuffer& out);
+      static int     validName             (const char* name, size_t length);
+      int            processExpressionWord (const char* word, int lineNumber,
+                                            OutputBuffer& out);
+      int            parseExpression       (const char* word, int lineNumber,
+                                            LabelFixup& fixup);
+      void           writeFixup            (LabelFixup& fixup,
+                                            OutputBuffer& out);
+      void           checkLabels           (void);
+      int            processMidiPitchBendWord(const char* word,
+                                            int lineNumber, OutputBuffer& out);
+      int            processVlvWord        (const char* word, int lineNumber,
+                                            OutputBuffer& out);
+      int            processLebWord        (const char* word, int lineNumber,
+                                            OutputBuffer& out);
+      int            processDecimalWord    (const char* word, int lineNumber,
+                                            OutputBuffer& out);
+      int            processHexadecimalWord(const char* word, int lineNumber,
+                                            OutputBuffer& out);
+      int            processStringWord     (const char* word, int lineNumber,
+                                            OutputBuffer& out);
+      int            processHexBlobWord    (const char* word, int lineNumber,
+                                            OutputBuffer& out);
+      int            processBase64Word     (const char* word, int lineNumber,
+                                            OutputBuffer& out);
+      int            processAsciiWord      (const char* word, int lineNumber,
+                                            OutputBuffer& out);
+      int            processBinaryWord     (const char* word, int lineNumber,
+                                            OutputBuffer& out);
+      int            error                 (int lineNumber, const char* token);
+      void           checkOutput           (void);
+};
+
+
+
+#endif  /* _BINASCCOMPILER_H_INCLUDED */
+
+
+
@@ -0,0 +1,486 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Mon Oct 19 04:02:33 PDT 2026
+// Last Modified: Mon Oct 19 04:02:33 PDT 2026
+// Last Modified: Mon Oct 19 04:41:18 PDT 2026 Added mergeTracks()
+// Filename:      ...binasc/BinascEventTable.cpp
+// Syntax:        C++
+//
+// Description:   The events of a MIDI file in a table with a column for
+//                each field.
+//
+
+#include "BinascEventTable.h"
+#include "ByteCodec.h"
+
+#include <algorithm>
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace std;
+
+
+// A MergeItem is the next event of a track while tracks are merged.
+class MergeItem {
+   public:
+      ulonglong      ticks;        // absolute time of the event
+      int            track;        // track of the event
+};
+
+
+//////////////////////////////
+//
+// readBigEndian -- read a big-endian number of count bytes.
+//
+
+static inline size_t readBigEndian(const uchar* data, int count) {
+   size_t value = 0;
+   for (int i=0; i<count; i++) {
+      value = (value << 8) | data[i];
+   }
+   return value;
+}
+
+
+
+//////////////////////////////
+//
+// laterItem -- ordering for a heap which keeps the earliest event on top.
+//     Events at the same time come out in track order.
+//
+
+static inline bool laterItem(const MergeItem& a, const MergeItem& b) {
+   return a.ticks > b.ticks || (a.ticks == b.ticks && a.track > b.track);
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::BinascEventTable --
+//
+
+BinascEventTable::BinascEventTable(void) {
+   fileType = 0;
+   division = 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::~BinascEventTable --
+//
+
+BinascEventTable::~BinascEventTable() {
+   // do nothing
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::read -- fill the table from a MIDI file in memory.
+//     Payload offsets refer to data, which the caller keeps.  Returns 0
+//     if the data is not a MIDI file; the table then holds the events
+//     read before the problem, and getError() describes it.
+//
+
+int BinascEventTable::read(const uchar* data, size_t size) {
+   clear();
+   if (size < 8 || memcmp(data, "MThd", 4) != 0) {
+      return fail("Not a MIDI file: MThd marker is missing");
+   }
+   size_t headerSize = readBigEndian(data + 4, 4);
+   if (headerSize < 6 || size - 8 < headerSize) {
+      return fail("Not a MIDI file: the header chunk is too short");
+   }
+   fileType = (int)readBigEndian(data + 8, 2);
+   int trackCount = (int)readBigEndian(data + 10, 2);
+   division = (int)readBigEndian(data + 12, 2);
+
+   size_t offset = 8 + headerSize;
+   int track = 0;
+   while (track < trackCount && size - offset >= 8) {
+      size_t length = readBigEndian(data + offset + 4, 4);
+      if (size - offset - 8 < length) {
+         trackStarts.push_back(getEventCount());
+         return fail("Not a MIDI file: a chunk is cut off");
+      }
+      if (memcmp(data + offset, "MTrk", 4) == 0) {
+         if (!readTrack(data, data + offset + 8, data + offset + 8 + length,
+               track)) {
+            trackStarts.push_back(getEventCount());
+            return 0;
+         }
+         track++;
+      }
+      offset += 8 + length;
+   }
+   trackStarts.push_back(getEventCount());
+   if (track < trackCount) {
+      return fail("Not a MIDI file: there are fewer tracks than the header "
+                  "says");
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::clear -- remove all of the events.
+//
+
+void BinascEventTable::clear(void) {
+   fileType = 0;
+   division = 0;
+   trackStarts.clear();
+   errorMessage.clear();
+   deltaTicks.clear();
+   absoluteTicks.clear();
+   status.clear();
+   data1.clear();
+   data2.clear();
+   tracks.clear();
+   payloadOffsets.clear();
+   payloadLengths.clear();
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getError -- returns the reason read() failed.
+//
+
+const char* BinascEventTable::getError(void) const {
+   return errorMessage.c_str();
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getFileType -- returns 0, 1 or 2, from the header.
+//
+
+int BinascEventTable::getFileType(void) const {
+   return fileType;
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getDivision -- returns the division field of the
+//     header: ticks per quarter note, or SMPTE timing if the top bit is
+//     set.
+//
+
+int BinascEventTable::getDivision(void) const {
+   return division;
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getTrackCount -- returns the number of tracks read.
+//
+
+int BinascEventTable::getTrackCount(void) const {
+   return trackStarts.empty() ? 0 : (int)trackStarts.size() - 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getEventCount -- returns the number of events in all
+//     of the tracks.
+//
+
+int BinascEventTable::getEventCount(void) const {
+   return (int)status.size();
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getTrackStart -- returns the index of the first event
+//     of a track.
+//
+
+int BinascEventTable::getTrackStart(int track) const {
+   return trackStarts[track];
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getTrackEnd -- returns the index after the last event
+//     of a track.
+//
+
+int BinascEventTable::getTrackEnd(int track) const {
+   return trackStarts[track + 1];
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::mergeTracks -- list the events of all tracks in order
+//     of absolute time.  Each track is already in time order, so the
+//     tracks are merged with a heap holding the next event of each one,
+//     taking O(n log k) time for n events in k tracks.  Events at the
+//     same time stay in track order, and in file order within a track.
+//     order receives the indexes of the events.
+//
+
+void BinascEventTable::mergeTracks(vector<int>& order) const {
+   order.clear();
+   order.reserve(getEventCount());
+   int trackCount = getTrackCount();
+   vector<int> next(trackCount);
+   vector<MergeItem> heap;
+   int track;
+   for (track=0; track<trackCount; track++) {
+      next[track] = trackStarts[track];
+      if (next[track] < trackStarts[track + 1]) {
+         MergeItem item;
+         item.ticks = absoluteTicks[next[track]];
+         item.track = track;
+         heap.push_back(item);
+      }
+   }
+   make_heap(heap.begin(), heap.end(), laterItem);
+
+   while (!heap.empty()) {
+      pop_heap(heap.begin(), heap.end(), laterItem);
+      MergeItem& item = heap.back();
+      track = item.track;
+      order.push_back(next[track]++);
+      if (next[track] < trackStarts[track + 1]) {
+         item.ticks = absoluteTicks[next[track]];
+         push_heap(heap.begin(), heap.end(), laterItem);
+      } else {
+         heap.pop_back();
+      }
+   }
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getDeltaTicks -- ticks from the previous event in the
+//     track to each event.
+//
+
+const vector<ulonglong>& BinascEventTable::getDeltaTicks(void) const {
+   return deltaTicks;
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getAbsoluteTicks -- ticks from the start of the track
+//     to each event.
+//
+
+const vector<ulonglong>& BinascEventTable::getAbsoluteTicks(void) const {
+   return absoluteTicks;
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getStatus -- the command byte of each event, given
+//     even where the file uses running status: 0x80-0xef for channel
+//     messages, 0xf0 or 0xf7 for system exclusive and 0xff for meta
+//     messages.
+//
+
+const vector<uchar>& BinascEventTable::getStatus(void) const {
+   return status;
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getData1 -- the first data byte of each channel
+//     message, or the type of a meta message.
+//
+
+const vector<uchar>& BinascEventTable::getData1(void) const {
+   return data1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getData2 -- the second data byte of each channel
+//     message which has one, and 0 otherwise.
+//
+
+const vector<uchar>& BinascEventTable::getData2(void) const {
+   return data2;
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getTracks -- the track number of each event.
+//
+
+const vector<ushort>& BinascEventTable::getTracks(void) const {
+   return tracks;
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getPayloadOffsets -- the offset in the buffer given to
+//     read() of the data of each meta or system exclusive message, or 0
+//     for channel messages.
+//
+
+const vector<ulonglong>& BinascEventTable::getPayloadOffsets(void) const {
+   return payloadOffsets;
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::getPayloadLengths -- the number of data bytes of each
+//     meta or system exclusive message, or 0 for channel messages.
+//
+
+const vector<uint>& BinascEventTable::getPayloadLengths(void) const {
+   return payloadLengths;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+
+//////////////////////////////
+//
+// BinascEventTable::readTrack -- add the events of the track chunk
+//     between start and end.  Each event is checked against the end of
+//     the chunk once its size is known.  Events after an end-of-track
+//     meta message are ignored.  Returns 0 if the track cannot be read.
+//
+
+int BinascEventTable::readTrack(const uchar* data, const uchar* start,
+      const uchar* end, int track) {
+   trackStarts.push_back(getEventCount());
+   const uchar* ptr = start;
+   ulonglong ticks = 0;
+   uchar running = 0;
+   string where = " in track " + to_string(track);
+
+   while (ptr < end) {
+      ulonglong delta;
+      int count = decodeVlv(ptr, end - ptr, delta);
+      if (count == 0 || end - ptr == count) {
+         return fail("invalid variable-length value" + where);
+      }
+      ptr += count;
+
+      uchar command = *ptr;
+      if (command < 0x80) {
+         if (running == 0) {
+            return fail("running status without a command" + where);
+         }
+         command = running;
+      } else {
+         ptr++;
+      }
+
+      uchar byte1 = 0;
+      uchar byte2 = 0;
+      ulonglong payload = 0;
+      ulonglong length = 0;
+      if (command < 0xf0) {
+         // channel message: two data bytes, or one for 0xc0 and 0xd0
+         int size = (command & 0xe0) == 0xc0 ? 1 : 2;
+         if (end - ptr < size) {
+            return fail("MIDI event is cut off" + where);
+         }
+         byte1 = ptr[0];
+         if (size == 2) {
+            byte2 = ptr[1];
+         }
+         ptr += size;
+         running = command;
+      } else if (command == 0xff || command == 0xf0 || command == 0xf7) {
+         // meta or system exclusive message: length and data
+         if (command == 0xff) {
+            if (ptr >= end) {
+               return fail("MIDI event is cut off" + where);
+            }
+            byte1 = *ptr++;
+         }
+         count = decodeVlv(ptr, end - ptr, length);
+         if (count == 0 || length > (ulonglong)(end - ptr - count)) {
+            return fail("MIDI event is cut off" + where);
+         }
+         ptr += count;
+         payload = ptr - data;
+         ptr += length;
+         running = 0;
+      } else {
+         char text[64];
+         snprintf(text, sizeof(text), "MIDI command %x cannot be in a file",
+               command);
+         return fail(text + where);
+      }
+
+      ticks += delta;
+      deltaTicks.push_back(delta);
+      absoluteTicks.push_back(ticks);
+      status.push_back(command);
+      data1.push_back(byte1);
+      data2.push_back(byte2);
+      tracks.push_back((ushort)track);
+      payloadOffsets.push_back(payload);
+      payloadLengths.push_back((uint)length);
+
+      if (command == 0xff && byte1 == 0x2f) {
+         break;
+      }
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascEventTable::fail -- store an error message.  Returns 0 for the
+//     caller to return.
+//
+
+int BinascEventTable::fail(const string& message) {
+   errorMessage = message;
+   return 0;
+}
+
+
+
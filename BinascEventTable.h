@@ -0,0 +1,87 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Mon Oct 19 04:02:33 PDT 2026
+// Last Modified: Mon Oct 19 04:02:33 PDT 2026
+// Last Modified: Mon Oct 19 04:41:18 PDT 2026 Added mergeTracks()
+// Filename:      ...binasc/BinascEventTable.h
+// Syntax:        C++
+//
+// Description:   The events of a MIDI file in a table with a column for
+//                each field, for programs which look at events rather
+//                than print them.  The table is filled in one pass over
+//                a file held in memory.  Event i of the file is entry i
+//                of every column; events are stored track by track, in
+//                the order of the file.  The data of meta and system
+//                exclusive messages is not copied: the table gives its
+//                offset and length in the buffer which was read.
+//
+//                Unlike the text listings, the table follows the
+//                Standard MIDI File rules exactly: meta and system
+//                exclusive lengths are variable-length values, each track
+//                ends at the end of its chunk, and chunks which are not
+//                tracks are skipped.
+//
+
+#ifndef _BINASCEVENTTABLE_H_INCLUDED
+#define _BINASCEVENTTABLE_H_INCLUDED
+
+#include "OutputBuffer.h"
+
+#include <string>
+#include <vector>
+
+
+class BinascEventTable {
+   public:
+                     BinascEventTable      (void);
+                    ~BinascEventTable      ();
+
+      int            read                  (const uchar* data, size_t size);
+      void           clear                 (void);
+      const char*    getError              (void) const;
+
+      int            getFileType           (void) const;
+      int            getDivision           (void) const;
+      int            getTrackCount         (void) const;
+      int            getEventCount         (void) const;
+      int            getTrackStart         (int track) const;
+      int            getTrackEnd           (int track) const;
+      void           mergeTracks           (std::vector<int>& order) const;
+
+      // columns, with one entry for each event
+      const std::vector<ulonglong>& getDeltaTicks    (void) const;
+      const std::vector<ulonglong>& getAbsoluteTicks (void) const;
+      const std::vector<uchar>&     getStatus        (void) const;
+      const std::vector<uchar>&     getData1         (void) const;
+      const std::vector<uchar>&     getData2         (void) const;
+      const std::vector<ushort>&    getTracks        (void) const;
+      const std::vector<ulonglong>& getPayloadOffsets(void) const;
+      const std::vector<uint>&      getPayloadLengths(void) const;
+
+   protected:
+      int            fileType;     // 0, 1 or 2 from the header
+      int            division;     // ticks per quarter note, or SMPTE
+      std::vector<int> trackStarts; // first event of each track, and end
+      std::string    errorMessage; // reason read() failed
+
+      std::vector<ulonglong> deltaTicks;    // ticks since the last event
+      std::vector<ulonglong> absoluteTicks; // ticks since the track start
+      std::vector<uchar>     status;        // command byte, never running
+      std::vector<uchar>     data1;         // first data byte; meta type
+      std::vector<uchar>     data2;         // second data byte, or 0
+      std::vector<ushort>    tracks;        // track of the event
+      std::vector<ulonglong> payloadOffsets; // meta or sysex data, or 0
+      std::vector<uint>      payloadLengths; // bytes of data, or 0
+
+      int            readTrack             (const uchar* data,
+                                            const uchar* start,
+                                            const uchar* end, int track);
+      int            fail                  (const std::string& message);
+};
+
+
+
+#endif  /* _BINASCEVENTTABLE_H_INCLUDED */
+
+
+
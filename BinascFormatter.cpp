@@ -0,0 +1,1210 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 19:12:44 PDT 2026
+// Last Modified: Sun Oct 18 19:12:44 PDT 2026
+// Last Modified: Mon Oct 19 02:05:51 PDT 2026 Stream input through a window
+// Last Modified: Mon Oct 19 02:48:16 PDT 2026 Read events with a pointer
+// Last Modified: Mon Oct 19 03:27:09 PDT 2026 List MIDI tracks in parallel
+// Last Modified: Mon Oct 19 04:41:18 PDT 2026 Merged MIDI listings
+// Last Modified: Mon Oct 19 06:51:09 PDT 2026 Thread count limited
+// Filename:      ...binasc/BinascFormatter.cpp
+// Syntax:        C++
+//
+// Description:   Converts bytes into the text listings which binasc
+//                prints: hexadecimal bytes with ASCII comments, hexadecimal
+//                bytes only, printable ASCII words only, or a MIDI file
+//                as text which can be compiled back into the file.  The
+//                format is given to each formatter rather than read from
+//                the command line, and the text goes into an OutputBuffer,
+//                so several formatters can run at the same time.  Input
+//                from a stream is read through a fixed window, so a file
+//                of any size is listed in constant memory, and the text
+//                of each event is passed on as soon as it is read.
+//                The tracks of a MIDI file held in memory can be listed
+//                on several threads, or merged into one track in time
+//                order.
+//
+
+#include "BinascFormatter.h"
+#include "BinascEventTable.h"
+#include "ByteCodec.h"
+
+#include <charconv>
+#include <thread>
+#include <vector>
+
+#include <ctype.h>
+#include <string.h>
+
+using namespace std;
+
+static const char hexDigits[] = "0123456789abcdef";
+
+// Longest MIDI event which readEvent() can read: a 10-byte delta time,
+// a command byte, a meta type, a count byte and 255 bytes of meta data.
+#define MIDI_EVENT_LONGEST  (10 + 3 + 255)
+
+// Longest text for such an event.
+#define MIDI_EVENT_TEXT     (32 + 3 * 255)
+
+
+//////////////////////////////
+//
+// writeText -- append a string to the output.
+//
+
+static inline void writeText(OutputBuffer& out, const char* text) {
+   out.write(text, strlen(text));
+}
+
+
+
+//////////////////////////////
+//
+// writeDecimal -- append a number in decimal.
+//
+
+static inline void writeDecimal(OutputBuffer& out, long long value) {
+   char digits[24];
+   to_chars_result result = to_chars(digits, digits + sizeof(digits), value);
+   out.write(digits, result.ptr - digits);
+}
+
+
+
+//////////////////////////////
+//
+// writeHex -- append a number in hexadecimal without leading zeros.
+//
+
+static inline void writeHex(OutputBuffer& out, unsigned int value) {
+   char digits[16];
+   to_chars_result result = to_chars(digits, digits + sizeof(digits),
+         value, 16);
+   out.write(digits, result.ptr - digits);
+}
+
+
+
+//////////////////////////////
+//
+// writeHexByte -- append a byte as two hexadecimal digits, followed by
+//     the given character.
+//
+
+static inline void writeHexByte(OutputBuffer& out, uchar value,
+      char after) {
+   uchar* output = out.reserve(3);
+   output[0] = hexDigits[value >> 4];
+   output[1] = hexDigits[value & 0x0f];
+   output[2] = after;
+}
+
+
+
+//////////////////////////////
+//
+// putDecimal -- store a number in decimal in a line of text, and return
+//     the end of the number.
+//
+
+static inline char* putDecimal(char* text, unsigned long long value) {
+   return to_chars(text, text + 24, value).ptr;
+}
+
+
+
+//////////////////////////////
+//
+// putHex -- store a byte in hexadecimal without a leading zero.
+//
+
+static inline char* putHex(char* text, uchar value) {
+   if (value >= 0x10) {
+      *text++ = hexDigits[value >> 4];
+   }
+   *text++ = hexDigits[value & 0x0f];
+   return text;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormat::BinascFormat -- the defaults of the binasc program.
+//
+
+BinascFormat::BinascFormat(void) {
+   style        = FORMAT_BOTH;
+   bytesPerLine = 25;
+   wrap         = 75;
+   commentQ     = 1;
+   threads      = 1;
+   mergeQ       = 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::BinascFormatter --
+//
+
+BinascFormatter::BinascFormatter(void) {
+   input       = NULL;
+   inputSize   = 0;
+   position    = 0;
+   source      = NULL;
+   window      = NULL;
+   windowStart = 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::~BinascFormatter --
+//
+
+BinascFormatter::~BinascFormatter() {
+   // do nothing
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::setFormat -- choose the style and layout of listings.
+//     The number of threads is kept between 1 and FORMAT_THREADS_MAX.
+//
+
+void BinascFormatter::setFormat(const BinascFormat& format) {
+   settings = format;
+   if (settings.threads < 1) {
+      settings.threads = 1;
+   } else if (settings.threads > FORMAT_THREADS_MAX) {
+      settings.threads = FORMAT_THREADS_MAX;
+   }
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::getFormat --
+//
+
+const BinascFormat& BinascFormatter::getFormat(void) const {
+   return settings;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::format -- write a listing of size bytes of data.
+//     Returns 0 if the format is invalid or the data cannot be listed
+//     in the MIDI style; getError() then describes the problem.
+//
+
+int BinascFormatter::format(const uchar* data, size_t size,
+      OutputBuffer& out) {
+   input       = data;
+   inputSize   = size;
+   position    = 0;
+   source      = NULL;
+   windowStart = 0;
+   return formatInput(out);
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::format -- write a listing of the bytes read from a
+//     stream.  Only a window of the input is kept in memory, except for
+//     a merged MIDI listing, which needs the whole file.
+//
+
+int BinascFormatter::format(istream& in, OutputBuffer& out) {
+   if (settings.style == FORMAT_MIDI && settings.mergeQ) {
+      vector<uchar> data;
+      char block[OUTPUTBUFFER_BLOCK];
+      while (in.read(block, sizeof(block)) || in.gcount() > 0) {
+         data.insert(data.end(), block, block + in.gcount());
+      }
+      return format(data.data(), data.size(), out);
+   }
+   window      = new uchar[OUTPUTBUFFER_BLOCK];
+   input       = window;
+   inputSize   = 0;
+   position    = 0;
+   source      = &in;
+   windowStart = 0;
+   int status = formatInput(out);
+   delete [] window;
+   window = NULL;
+   input  = NULL;
+   source = NULL;
+   return status;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::getError -- returns the reason the last call to
+//     format() failed.
+//
+
+const char* BinascFormatter::getError(void) const {
+   return errorMessage.c_str();
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+
+//////////////////////////////
+//
+// BinascFormatter::formatInput -- write a listing in the chosen style.
+//
+
+int BinascFormatter::formatInput(OutputBuffer& out) {
+   errorMessage.clear();
+   switch (settings.style) {
+      case FORMAT_HEX:   return formatHex(out);
+      case FORMAT_ASCII: return formatAscii(out);
+      case FORMAT_MIDI:  return formatMidiFile(out);
+   }
+   return formatBoth(out);
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::refill -- make at least count bytes available from
+//     position, reading more of the source if there is one.  Unread bytes
+//     are moved to the start of the window first.  Returns 0 if the input
+//     ends sooner.  count must not be more than the size of the window.
+//
+
+int BinascFormatter::refill(size_t count) {
+   if (inputSize - position >= count) {
+      return 1;
+   }
+   if (source == NULL) {
+      return 0;
+   }
+   memmove(window, window + position, inputSize - position);
+   windowStart += position;
+   inputSize   -= position;
+   position     = 0;
+   while (inputSize < count && *source) {
+      source->read((char*)window + inputSize, OUTPUTBUFFER_BLOCK - inputSize);
+      inputSize += source->gcount();
+   }
+   return inputSize >= count;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::tell -- returns the offset of the next byte to read.
+//
+
+ulonglong BinascFormatter::tell(void) const {
+   return windowStart + position;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::formatAscii -- output bytes in ascii form, not
+//    displaying any blank lines.  Output words are not broken unless
+//    they are longer than the wrap length.
+//
+
+int BinascFormatter::formatAscii(OutputBuffer& out) {
+   int maxLineLength = settings.wrap; // max line length for output
+   if (maxLineLength < 1) {
+      return fail("Error invalid colmn wrap specified");
+   }
+   string word;                   // current word while it may fit the line
+   int longQ = 0;                 // current word is written as it is read
+   int lineCount = 0;             // current length of line
+   size_t i;
+
+   while (refill(1)) {
+      for (i=position; i<inputSize; i++) {
+         if (isprint(input[i]) && !isspace(input[i])) {
+            if (longQ) {
+               out << (char)input[i];
+               lineCount++;
+               continue;
+            }
+            word += (char)input[i];
+            if ((int)word.size() + lineCount >= maxLineLength) {
+               // too long for the current line: put it on the next line,
+               // and write the rest of it as it is read
+               if (lineCount != 0) {
+                  out << '\n';
+               }
+               out.write(word.data(), word.size());
+               lineCount = word.size();
+               word.clear();
+               longQ = 1;
+            }
+            continue;
+         }
+
+         // end of a word which fits on the current line
+         longQ = 0;
+         if (word.empty()) {
+            continue;
+         }
+         if (lineCount != 0) {
+            out << ' ';
+            lineCount++;
+         }
+         out.write(word.data(), word.size());
+         lineCount += word.size();
+         word.clear();
+      }
+      position = inputSize;
+   }
+   if (!word.empty()) {
+      if (lineCount != 0) {
+         out << ' ';
+         lineCount++;
+      }
+      out.write(word.data(), word.size());
+      lineCount += word.size();
+   }
+
+   if (lineCount != 0) {
+      out << '\n';
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::formatHex -- output bytes in ascii form, hexadecimal
+//     numbers only.
+//
+
+int BinascFormatter::formatHex(OutputBuffer& out) {
+   int maxByteInLine = settings.bytesPerLine; // max line length for output
+   if (maxByteInLine < 1) {
+      return fail("Error invalid byte count specified");
+   }
+   int currentByte = 0;           // current byte output in line
+
+   if (!refill(1)) {
+      writeText(out, "End of the file right away!\n");
+   }
+
+   size_t i;
+   while (refill(1)) {
+      for (i=position; i<inputSize; i++) {
+         writeHexByte(out, input[i], ' ');
+         currentByte++;
+         if (currentByte >= maxByteInLine) {
+            out << '\n';
+            currentByte = 0;
+         }
+      }
+      position = inputSize;
+   }
+
+   if (currentByte != 0) {
+      out << '\n';
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::formatBoth -- output bytes in ascii form with both
+//     hexadecimal numbers and ascii representation
+//
+
+int BinascFormatter::formatBoth(OutputBuffer& out) {
+   int maxByteInLine = settings.bytesPerLine; // max line length for output
+   if (maxByteInLine < 1) {
+      return fail("Error invalid byte count specified");
+   }
+   string asciiLine;              // comment line for the current bytes
+   int currentByte = 0;           // current byte output in line
+
+   size_t i;
+   while (refill(1)) {
+      for (i=position; i<inputSize; i++) {
+         uchar ch = input[i];
+         if (currentByte == 0) {
+            asciiLine = ";";
+            out << ' ';
+         }
+         writeHexByte(out, ch, ' ');
+         currentByte++;
+
+         asciiLine += ' ';
+         asciiLine += isprint(ch) ? (char)ch : ' ';
+         asciiLine += ' ';
+
+         if (currentByte >= maxByteInLine) {
+            out << '\n';
+            out.write(asciiLine.data(), asciiLine.size());
+            writeText(out, "\n\n");
+            currentByte = 0;
+         }
+      }
+      position = inputSize;
+   }
+
+   if (currentByte != 0) {
+      out << '\n';
+      out.write(asciiLine.data(), asciiLine.size());
+      writeText(out, "\n\n");
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::formatMidiFile -- output bytes parsed as a MIDI file.
+//     Returns 0 if the data is not a MIDI file.
+//
+
+int BinascFormatter::formatMidiFile(OutputBuffer& out) {
+   if (settings.mergeQ) {
+      return formatMergedMidi(out);
+   }
+   uchar ch;
+
+   // Read the MIDI file header
+
+   // The first four bytes must be the characters "MThd"
+   if (!expectBytes("MThd")) {
+      return 0;
+   }
+   writeText(out, "+M +T +h +d");
+   if (settings.commentQ) {
+      writeText(out, "\t\t; MIDI header chunk marker");
+   }
+   out << '\n';
+
+   if (!refill(10)) {
+      return fail("Not a MIDI file: the header chunk is too short");
+   }
+
+   // The next four bytes are a big-endian byte count for the header
+   // which should nearly always be "6"
+   int headersize = 0;
+   int i;
+   for (i=0; i<4; i++) {
+      readByte(ch);
+      headersize = (headersize << 8) | ch;
+   }
+   writeText(out, "4'");
+   writeDecimal(out, headersize);
+   if (settings.commentQ) {
+      writeText(out, "\t\t\t; bytes to follow in header chunk");
+   }
+   out << '\n';
+
+   // first number in header is two-byte file type
+   int filetype = 0;
+   readByte(ch);
+   filetype = (filetype << 8) | ch;
+   readByte(ch);
+   filetype = (filetype << 8) | ch;
+   writeText(out, "2'");
+   writeDecimal(out, filetype);
+   if (settings.commentQ) {
+      writeText(out, "\t\t\t; file format: Type-");
+      writeDecimal(out, filetype);
+      writeText(out, " (");
+      switch (filetype) {
+         case 0:  writeText(out, "single track"); break;
+         case 1:  writeText(out, "multitrack");   break;
+         case 2:  writeText(out, "multisegment"); break;
+         default: writeText(out, "unknown");      break;
+      }
+      writeText(out, ")");
+   }
+   out << '\n';
+
+   // second number in header is two-byte trackcount
+   int trackcount = 0;
+   readByte(ch);
+   trackcount = (trackcount << 8) | ch;
+   readByte(ch);
+   trackcount = (trackcount << 8) | ch;
+   writeText(out, "2'");
+   writeDecimal(out, trackcount);
+   if (settings.commentQ) {
+      writeText(out, "\t\t\t; number of tracks");
+   }
+   out << '\n';
+
+   // third number is divisions.  This can be one of two types:
+   // regular: top bit is 0: number of ticks per quarter note
+   // SMPTE:   top bit is 1: first byte is negative frames, second is
+   //          ticks per frame.
+   uchar byte1;
+   uchar byte2;
+   readByte(byte1);
+   readByte(byte2);
+   if (byte1 & 0x80) {
+      // SMPTE divisions
+      writeText(out, "1'-");
+      writeDecimal(out, 0xff - (int)byte1 + 1);
+      if (settings.commentQ) {
+         writeText(out, "\t\t\t; SMPTE frames/second");
+      }
+      out << '\n';
+      writeText(out, "1'");
+      writeDecimal(out, byte2);
+      if (settings.commentQ) {
+         writeText(out, "\t\t\t; subframes per frame");
+      }
+      out << '\n';
+   } else {
+      // regular divisions
+      int divisions = 0;
+      divisions = (divisions << 8) | byte1;
+      divisions = (divisions << 8) | byte2;
+      writeText(out, "2'");
+      writeDecimal(out, divisions);
+      if (settings.commentQ) {
+         writeText(out, "\t\t\t; ticks per quarter note");
+      }
+      out << '\n';
+   }
+
+   // print any strange bytes in header:
+   for (i=0; i<headersize - 6; i++) {
+      if (!readByte(ch)) {
+         return fail("Not a MIDI file: the header chunk is too short");
+      }
+      writeHexByte(out, ch, ' ');
+   }
+   if (headersize - 6 > 0) {
+      writeText(out, "\t\t\t; unknown header bytes\n");
+   }
+
+   // tracks of a file in memory may be listed by worker threads first
+   i = 0;
+   if (settings.threads > 1 && source == NULL && trackcount > 1) {
+      i = formatTracks(out, trackcount);
+   }
+   for ( ; i<trackcount; i++) {
+      if (!formatTrack(out, i)) {
+         return 0;
+      }
+   }
+
+   out << '\n';
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::formatTrack -- list the MIDI track starting at the
+//     current position.  Returns 0 if it cannot be read.
+//
+
+int BinascFormatter::formatTrack(OutputBuffer& out, int track) {
+   uchar ch;
+   writeText(out, "\n; TRACK ");
+   writeDecimal(out, track);
+   writeText(out, " ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;\n");
+
+   // The first four bytes of a track must be the characters "MTrk"
+   if (!expectBytes("MTrk")) {
+      return 0;
+   }
+   writeText(out, "+M +T +r +k");
+   if (settings.commentQ) {
+      writeText(out, "\t\t; MIDI track chunk marker");
+   }
+   out << '\n';
+
+   // The next four bytes are a big-endian byte count for the track
+   int tracksize = 0;
+   int j;
+   for (j=0; j<4; j++) {
+      if (!readByte(ch)) {
+         return fail("Not a MIDI file: a track chunk is too short");
+      }
+      tracksize = (tracksize << 8) | ch;
+   }
+   writeText(out, "4'");
+   writeDecimal(out, tracksize);
+   if (settings.commentQ) {
+      writeText(out, "\t\t\t; bytes to follow in track chunk");
+   }
+   out << '\n';
+
+   ulonglong trackstart = tell();
+   int command = 0;
+
+   // process MIDI events until the end of the track
+   while (readEvent(out, command)) { out << '\n'; };
+   if (!errorMessage.empty()) {
+      return 0;
+   }
+   out << '\n';
+
+   ulonglong trackbytes = tell() - trackstart;
+   if (trackbytes != (ulonglong)tracksize) {
+      writeText(out, "; TRACK SIZE ERROR, ACTUAL SIZE: ");
+      writeDecimal(out, trackbytes);
+      out << '\n';
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::formatTracks -- list MIDI tracks on worker threads.
+//     The tracks are found from the sizes in their chunk headers, and
+//     each is listed into memory and passed to the output in order.  The
+//     listing of a track is only used if its events end where its size
+//     says; otherwise that track and the ones after it are left for the
+//     caller to list in order, so the listing is the same as without
+//     threads.  Workers stay a few tracks ahead of the output to limit
+//     memory.  Returns the number of tracks listed, leaving the position
+//     at the start of the next one.
+//
+
+int BinascFormatter::formatTracks(OutputBuffer& out, int trackcount) {
+   vector<TrackJob> found;
+   size_t offset = position;
+   while ((int)found.size() < trackcount && inputSize - offset >= 8 &&
+         memcmp(input + offset, "MTrk", 4) == 0) {
+      TrackJob job;
+      job.start = offset;
+      job.end   = offset + 8 + ((size_t)input[offset + 4] << 24 |
+            (size_t)input[offset + 5] << 16 | (size_t)input[offset + 6] << 8 |
+            (size_t)input[offset + 7]);
+      job.text  = NULL;
+      job.doneQ = 0;
+      job.goodQ = 0;
+      found.push_back(job);
+      if (job.end > inputSize) {
+         break;
+      }
+      offset = job.end;
+   }
+   if (found.size() < 2) {
+      return 0;
+   }
+
+   TrackJobs jobs;
+   jobs.tracks  = found.data();
+   jobs.count   = (int)found.size();
+   jobs.next    = 0;
+   jobs.written = 0;
+   jobs.stopQ   = 0;
+   int threadCount = settings.threads < jobs.count ? settings.threads :
+         jobs.count;
+   jobs.ahead   = threadCount * 2;
+   vector<thread> threads;
+   int i;
+   for (i=0; i<threadCount; i++) {
+      threads.push_back(thread(&BinascFormatter::trackWorker, this,
+            std::ref(jobs)));
+   }
+
+   int track;
+   for (track=0; track<jobs.count; track++) {
+      TrackJob& job = jobs.tracks[track];
+      unique_lock<mutex> guard(jobs.lock);
+      while (!job.doneQ) {
+         jobs.signal.wait(guard);
+      }
+      if (!job.goodQ) {
+         break;
+      }
+      guard.unlock();
+      out.write(job.text->getData(), job.text->getSize());
+      delete job.text;
+      job.text = NULL;
+      guard.lock();
+      jobs.written = track + 1;
+      jobs.signal.notify_all();
+   }
+
+   {
+      lock_guard<mutex> guard(jobs.lock);
+      jobs.stopQ = 1;
+      jobs.signal.notify_all();
+   }
+   for (i=0; i<(int)threads.size(); i++) {
+      threads[i].join();
+   }
+   for (i=track; i<jobs.count; i++) {
+      delete jobs.tracks[i].text;
+   }
+   position = track < jobs.count ? jobs.tracks[track].start :
+         jobs.tracks[track - 1].end;
+   return track;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::trackWorker -- list tracks for formatTracks() with a
+//     formatter of the thread's own, until there are none left or the
+//     workers are stopped.
+//
+
+void BinascFormatter::trackWorker(TrackJobs& jobs) {
+   BinascFormatter decoder;
+   decoder.settings  = settings;
+   decoder.input     = input;
+   decoder.inputSize = inputSize;
+
+   unique_lock<mutex> guard(jobs.lock);
+   while (1) {
+      while (!jobs.stopQ && jobs.next < jobs.count &&
+            jobs.next >= jobs.written + jobs.ahead) {
+         jobs.signal.wait(guard);
+      }
+      if (jobs.stopQ || jobs.next >= jobs.count) {
+         return;
+      }
+      int track = jobs.next++;
+      guard.unlock();
+
+      TrackJob& job = jobs.tracks[track];
+      OutputBuffer* text = new OutputBuffer;
+      decoder.position = job.start;
+      decoder.errorMessage.clear();
+      int goodQ = decoder.formatTrack(*text, track) &&
+            decoder.position == job.end;
+
+      guard.lock();
+      job.text  = text;
+      job.goodQ = goodQ;
+      job.doneQ = 1;
+      jobs.signal.notify_all();
+   }
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::formatMergedMidi -- list the events of all tracks of
+//     a MIDI file in memory as a single track in order of time, with delta
+//     times from one event to the next.  The listing compiles into a
+//     type-0 MIDI file.  End-of-track messages are replaced by one at the
+//     end of the last track.  Returns 0 if the data cannot be read as a
+//     MIDI file.
+//
+
+int BinascFormatter::formatMergedMidi(OutputBuffer& out) {
+   BinascEventTable table;
+   if (!table.read(input, inputSize)) {
+      return fail(table.getError());
+   }
+   vector<int> order;
+   table.mergeTracks(order);
+
+   writeText(out, "+M +T +h +d");
+   if (settings.commentQ) {
+      writeText(out, "\t\t; MIDI header chunk marker");
+   }
+   writeText(out, "\n4'6");
+   if (settings.commentQ) {
+      writeText(out, "\t\t\t; bytes to follow in header chunk");
+   }
+   writeText(out, "\n2'0");
+   if (settings.commentQ) {
+      writeText(out, "\t\t\t; file format: Type-0 (");
+      writeDecimal(out, table.getTrackCount());
+      writeText(out, " tracks merged)");
+   }
+   writeText(out, "\n2'1");
+   if (settings.commentQ) {
+      writeText(out, "\t\t\t; number of tracks");
+   }
+   out << '\n';
+   int division = table.getDivision();
+   if (division & 0x8000) {
+      writeText(out, "1'-");
+      writeDecimal(out, 0x100 - (division >> 8));
+      if (settings.commentQ) {
+         writeText(out, "\t\t\t; SMPTE frames/second");
+      }
+      writeText(out, "\n1'");
+      writeDecimal(out, division & 0xff);
+      if (settings.commentQ) {
+         writeText(out, "\t\t\t; subframes per frame");
+      }
+   } else {
+      writeText(out, "2'");
+      writeDecimal(out, division);
+      if (settings.commentQ) {
+         writeText(out, "\t\t\t; ticks per quarter note");
+      }
+   }
+
+   writeText(out, "\n\n; MERGED TRACKS ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;\n");
+   writeText(out, "+M +T +r +k");
+   if (settings.commentQ) {
+      writeText(out, "\t\t; MIDI track chunk marker");
+   }
+   writeText(out, "\n4'(end-start)");
+   if (settings.commentQ) {
+      writeText(out, "\t\t; bytes to follow in track chunk");
+   }
+   writeText(out, "\nstart:\n");
+
+   const vector<ulonglong>& ticks = table.getAbsoluteTicks();
+   const vector<uchar>& status = table.getStatus();
+   const vector<uchar>& data1 = table.getData1();
+   const vector<uchar>& data2 = table.getData2();
+   const vector<ushort>& tracks = table.getTracks();
+   const vector<ulonglong>& offsets = table.getPayloadOffsets();
+   const vector<uint>& lengths = table.getPayloadLengths();
+   // Each line is built in text and written at once, as in readEvent().
+   char text[MIDI_EVENT_TEXT];
+   char* tptr;
+   ulonglong now = 0;
+   ulonglong endTicks = 0;
+   for (int i=0; i<(int)order.size(); i++) {
+      int event = order[i];
+      uchar command = status[event];
+      if (command == 0xff && data1[event] == 0x2f) {
+         endTicks = ticks[event];
+         continue;
+      }
+      tptr = text;
+      *tptr++ = 'v';
+      tptr = putDecimal(tptr, ticks[event] - now);
+      *tptr++ = '\t';
+      now = ticks[event];
+      tptr = putHex(tptr, command);
+      if (command == 0xff || command == 0xf0 || command == 0xf7) {
+         if (command == 0xff) {
+            *tptr++ = ' ';
+            tptr = putHex(tptr, data1[event]);
+         }
+         *tptr++ = ' ';
+         *tptr++ = 'v';
+         tptr = putDecimal(tptr, lengths[event]);
+         const uchar* payload = input + offsets[event];
+         for (uint j=0; j<lengths[event]; j++) {
+            if (tptr - text > MIDI_EVENT_TEXT - 32) {
+               out.write(text, tptr - text);
+               tptr = text;
+            }
+            *tptr++ = ' ';
+            tptr = putHex(tptr, payload[j]);
+         }
+      } else {
+         *tptr++ = ' ';
+         *tptr++ = '\'';
+         tptr = putDecimal(tptr, data1[event]);
+         if ((command & 0xe0) != 0xc0) {
+            *tptr++ = ' ';
+            *tptr++ = '\'';
+            tptr = putDecimal(tptr, data2[event]);
+         }
+      }
+      // The comment and newline take at most 64 bytes.
+      if (tptr - text > MIDI_EVENT_TEXT - 64) {
+         out.write(text, tptr - text);
+         tptr = text;
+      }
+      if (settings.commentQ) {
+         memcpy(tptr, "\t; track ", 9);
+         tptr = putDecimal(tptr + 9, tracks[event]);
+         memcpy(tptr, ", tick ", 7);
+         tptr = putDecimal(tptr + 7, now);
+      }
+      *tptr++ = '\n';
+      out.write(text, tptr - text);
+   }
+   out << 'v';
+   writeDecimal(out, (long long)(endTicks > now ? endTicks - now : 0));
+   writeText(out, "\tff 2f v0");
+   if (settings.commentQ) {
+      writeText(out, "\t; end of track");
+   }
+   writeText(out, "\nend:\n\n");
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::readEvent -- read a delta time and then a MIDI message
+//     (or meta message).  Returns 1 if not end-of-track meta message;
+//     0 otherwise, or if the event cannot be read.  When the longest
+//     possible event is in the window, the bytes are read with a pointer
+//     without checking each one; near the end of the input the event is
+//     read by readCheckedEvent() instead.
+//
+
+int BinascFormatter::readEvent(OutputBuffer& out, int& command) {
+   if (!refill(MIDI_EVENT_LONGEST)) {
+      return readCheckedEvent(out, command);
+   }
+   const uchar* ptr = input + position;
+   ulonglong vlv;
+   int count = decodeVlv(ptr, 10, vlv);
+   if (count == 0) {
+      return fail("invalid variable-length value in MIDI file");
+   }
+   ptr += count;
+
+   // the text of the event is put together here and written at once
+   char text[MIDI_EVENT_TEXT];
+   char* tptr = text;
+   *tptr++ = 'v';
+   tptr = putDecimal(tptr, vlv);
+   *tptr++ = '\t';
+
+   uchar ch = *ptr++;
+   if (ch < 0x80) {
+      // running status: command byte is previous one in data stream
+      memcpy(tptr, "   ", 3);
+      tptr += 3;
+   } else {
+      // midi command byte
+      tptr = putHex(tptr, ch);
+      command = ch;
+      ch = *ptr++;
+   }
+   int status = 1;
+   int i;
+   switch (command & 0xf0) {
+      case 0x80:    // note-off: 2 bytes
+      case 0x90:    // note-on: 2 bytes
+      case 0xA0:    // aftertouch: 2 bytes
+      case 0xB0:    // continuous controller: 2 bytes
+      case 0xE0:    // pitch-bend: 2 bytes
+         *tptr++ = ' ';
+         *tptr++ = '\'';
+         tptr = putDecimal(tptr, ch);
+         *tptr++ = ' ';
+         *tptr++ = '\'';
+         tptr = putDecimal(tptr, *ptr++);
+         break;
+      case 0xC0:    // patch change: 1 bytes
+      case 0xD0:    // channel pressure: 1 bytes
+         *tptr++ = ' ';
+         *tptr++ = '\'';
+         tptr = putDecimal(tptr, ch);
+         break;
+      case 0xF0:    // various system bytes: variable bytes
+         if (command == 0xfe) {
+            out.write(text, tptr - text);
+            return fail("MIDI command fe is not handled yet");
+         }
+         if (command == 0xff) {
+            // meta message
+            *tptr++ = ' ';
+            tptr = putHex(tptr, ch);
+            count = *ptr++;
+            *tptr++ = ' ';
+            *tptr++ = '\'';
+            tptr = putDecimal(tptr, count);
+            for (i=0; i<count; i++) {
+               *tptr++ = ' ';
+               tptr = putHex(tptr, *ptr++);
+            }
+            if (ch == 0x2f) {
+               status = 0;
+            }
+         }
+         break;
+   }
+   out.write(text, tptr - text);
+   position = ptr - input;
+   return status;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::readCheckedEvent -- read an event as readEvent() does,
+//     checking for the end of the input before each byte.
+//
+
+int BinascFormatter::readCheckedEvent(OutputBuffer& out, int& command) {
+   // read and print Variable Length Value for delta ticks
+   ulonglong vlv;
+   if (!getVLV(vlv)) {
+      return 0;
+   }
+   out << 'v';
+   writeDecimal(out, (long long)vlv);
+   out << '\t';
+
+   uchar byte1, byte2;
+   uchar ch;
+   if (!readByte(ch)) {
+      return fail("MIDI track ends in the middle of an event");
+   }
+   if (ch < 0x80) {
+      // running status: command byte is previous one in data stream
+      writeText(out, "   ");
+   } else {
+      // midi command byte
+      writeHex(out, ch);
+      command = ch;
+      if (!readByte(ch)) {
+         return fail("MIDI track ends in the middle of an event");
+      }
+   }
+   byte1 = ch;
+   int count;
+   int i;
+   int metatype = 0;
+   switch (command & 0xf0) {
+      case 0x80:    // note-off: 2 bytes
+      case 0x90:    // note-on: 2 bytes
+      case 0xA0:    // aftertouch: 2 bytes
+      case 0xB0:    // continuous controller: 2 bytes
+      case 0xE0:    // pitch-bend: 2 bytes
+         writeText(out, " '");
+         writeDecimal(out, byte1);
+         if (!readByte(byte2)) {
+            return fail("MIDI track ends in the middle of an event");
+         }
+         writeText(out, " '");
+         writeDecimal(out, byte2);
+         break;
+      case 0xC0:    // patch change: 1 bytes
+      case 0xD0:    // channel pressure: 1 bytes
+         writeText(out, " '");
+         writeDecimal(out, byte1);
+         break;
+      case 0xF0:    // various system bytes: variable bytes
+         switch (command) {
+            case 0xfe:
+               return fail("MIDI command fe is not handled yet");
+            case 0xff:  // meta message
+               metatype = ch;
+               out << ' ';
+               writeHex(out, metatype);
+               if (!readByte(ch)) {
+                  return fail("MIDI track ends in the middle of an event");
+               }
+               count = ch;
+               writeText(out, " '");
+               writeDecimal(out, count);
+               for (i=0; i<count; i++) {
+                  if (!readByte(ch)) {
+                     return fail("MIDI track ends in the middle of an "
+                                 "event");
+                  }
+                  out << ' ';
+                  writeHex(out, ch);
+               }
+               if (metatype == 0x2f) {
+                  return 0;
+               }
+               break;
+         }
+         break;
+   }
+
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::getVLV -- read a Variable-Length Value from the input.
+//     Returns 0 if it is cut off or too long.
+//
+
+int BinascFormatter::getVLV(ulonglong& value) {
+   refill(10);         // room for the longest VLV
+   int count = decodeVlv(input + position, inputSize - position, value);
+   if (count == 0) {
+      return fail("invalid variable-length value in MIDI file");
+   }
+   position += count;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::readByte -- read the next byte of input.  Returns 0 at
+//     the end of the input.
+//
+
+int BinascFormatter::readByte(uchar& ch) {
+   if (position >= inputSize && !refill(1)) {
+      return 0;
+   }
+   ch = input[position++];
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::expectBytes -- read the four characters of a chunk
+//     marker such as "MTrk".  Returns 0 if they are not next in the input.
+//
+
+int BinascFormatter::expectBytes(const char* marker) {
+   size_t length = strlen(marker);
+   if (!refill(length) ||
+         memcmp(input + position, marker, length) != 0) {
+      errorMessage = string("Not a MIDI file: ") + marker +
+            " marker is missing";
+      return 0;
+   }
+   position += length;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascFormatter::fail -- store an error message.  Returns 0 for the
+//     caller to return.
+//
+
+int BinascFormatter::fail(const char* message) {
+   errorMessage = message;
+   return 0;
+}
+
+
+
@@ -0,0 +1,134 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 19:12:44 PDT 2026
+// Last Modified: Sun Oct 18 19:12:44 PDT 2026
+// Last Modified: Mon Oct 19 02:05:51 PDT 2026 Stream input through a window
+// Last Modified: Mon Oct 19 02:48:16 PDT 2026 Read events with a pointer
+// Last Modified: Mon Oct 19 03:27:09 PDT 2026 List MIDI tracks in parallel
+// Last Modified: Mon Oct 19 04:41:18 PDT 2026 Merged MIDI listings
+// Last Modified: Mon Oct 19 06:51:09 PDT 2026 Thread count limited
+// Filename:      ...binasc/BinascFormatter.h
+// Syntax:        C++
+//
+// Description:   Converts bytes into the text listings which binasc
+//                prints: hexadecimal bytes with ASCII comments, hexadecimal
+//                bytes only, printable ASCII words only, or a MIDI file
+//                as text which can be compiled back into the file.  The
+//                format is given to each formatter rather than read from
+//                the command line, and the text goes into an OutputBuffer,
+//                so several formatters can run at the same time.  Input
+//                from a stream is read through a fixed window, so a file
+//                of any size is listed in constant memory, and the text
+//                of each event is passed on as soon as it is read.
+//                The tracks of a MIDI file held in memory can be listed
+//                on several threads, or merged into one track in time
+//                order.
+//
+
+#ifndef _BINASCFORMATTER_H_INCLUDED
+#define _BINASCFORMATTER_H_INCLUDED
+
+#include "OutputBuffer.h"
+
+#include <istream>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+
+// Output styles for BinascFormat:
+#define FORMAT_BOTH   0     // hexadecimal bytes and ASCII comment lines
+#define FORMAT_HEX    1     // hexadecimal bytes only (-b option)
+#define FORMAT_ASCII  2     // printable ASCII words only (-a option)
+#define FORMAT_MIDI   3     // MIDI file as binasc text (-m option)
+
+// Most threads which list the tracks of one MIDI file.
+#define FORMAT_THREADS_MAX  64
+
+
+class BinascFormat {
+   public:
+                     BinascFormat          (void);
+
+      int            style;        // one of the FORMAT_ styles
+      int            bytesPerLine; // bytes on each hexadecimal line
+      int            wrap;         // maximum line length for ASCII words
+      int            commentQ;     // add comments to MIDI listings
+      int            threads;      // threads for listing MIDI tracks
+      int            mergeQ;       // list MIDI tracks as one, by time
+};
+
+
+class BinascFormatter {
+   public:
+                     BinascFormatter       (void);
+                    ~BinascFormatter       ();
+
+      void           setFormat             (const BinascFormat& format);
+      const BinascFormat& getFormat        (void) const;
+
+      int            format                (const uchar* data, size_t size,
+                                            OutputBuffer& out);
+      int            format                (std::istream& in,
+                                            OutputBuffer& out);
+      const char*    getError              (void) const;
+
+   protected:
+      // A TrackJob is a MIDI track listed by a worker thread.
+      class TrackJob {
+         public:
+            size_t          start;    // offset of the track chunk
+            size_t          end;      // offset after it, from its size
+            OutputBuffer*   text;     // listing of the track, or NULL
+            int             doneQ;    // the worker has finished
+            int             goodQ;    // listed without errors up to end
+      };
+
+      // TrackJobs are the tracks of a file and the state shared by the
+      // threads listing them.
+      class TrackJobs {
+         public:
+            TrackJob*       tracks;   // tracks found from chunk sizes
+            int             count;    // number of tracks
+            int             next;     // next track for a worker
+            int             written;  // tracks passed to the output
+            int             ahead;    // most tracks listed before written
+            int             stopQ;    // workers should finish
+            std::mutex      lock;     // guards all but tracks[].start/end
+            std::condition_variable signal; // a job or the output moved
+      };
+
+      BinascFormat   settings;     // how to print the bytes
+      std::string    errorMessage; // reason the last format() failed
+      const uchar*   input;        // bytes being formatted
+      size_t         inputSize;    // number of bytes in input
+      size_t         position;     // next byte to read from input
+      std::istream*  source;       // stream which refills input, or NULL
+      uchar*         window;       // storage for input from source
+      ulonglong      windowStart;  // offset in the stream of input[0]
+
+      int            formatInput           (OutputBuffer& out);
+      int            refill                (size_t count);
+      ulonglong      tell                  (void) const;
+      int            formatAscii           (OutputBuffer& out);
+      int            formatHex             (OutputBuffer& out);
+      int            formatBoth            (OutputBuffer& out);
+      int            formatMidiFile        (OutputBuffer& out);
+      int            formatTrack           (OutputBuffer& out, int track);
+      int            formatTracks          (OutputBuffer& out,
+                                            int trackcount);
+      void           trackWorker           (TrackJobs& jobs);
+      int            formatMergedMidi      (OutputBuffer& out);
+      int            readEvent             (OutputBuffer& out, int& command);
+      int            readCheckedEvent      (OutputBuffer& out, int& command);
+      int            getVLV                (ulonglong& value);
+      int            readByte              (uchar& ch);
+      int            expectBytes           (const char* marker);
+      int            fail                  (const char* message);
+};
+
+
+
+#endif  /* _BINASCFORMATTER_H_INCLUDED */
+
+
+
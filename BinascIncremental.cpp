@@ -0,0 +1,596 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 22:03:26 PDT 2026
+// Last Modified: Sun Oct 18 22:03:26 PDT 2026
+// Last Modified: Mon Oct 19 01:14:38 PDT 2026 Macros compile whole
+// Filename:      ...binasc/BinascIncremental.cpp
+// Syntax:        C++
+//
+// Description:   Compiles a large source file again after small changes
+//                without compiling all of it.
+//
+
+#include "BinascIncremental.h"
+#include "BinascCache.h"
+
+#include <fstream>
+#include <sstream>
+#include <map>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// first word of a chunk list file
+#define CHUNK_LIST_MARKER "binasc-chunks"
+
+#ifdef __APPLE__
+   #define st_mtim st_mtimespec
+#endif
+
+
+//////////////////////////////
+//
+// getVersionHash -- hash of the compiler version, which starts the hash
+//     of every chunk.
+//
+
+static ulonglong getVersionHash(void) {
+   return BinascCache::hash(BINASC_CACHE_VERSION,
+         strlen(BINASC_CACHE_VERSION));
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::BinascIncremental --
+//
+
+BinascIncremental::BinascIncremental(void) {
+   writtenBytes  = 0;
+   compiledCount = 0;
+   incrementalQ  = 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::~BinascIncremental --
+//
+
+BinascIncremental::~BinascIncremental() {
+   // do nothing
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::compile -- compile a source file into an output
+//     file, reusing the output of the last run for chunks of the source
+//     which have not changed.  If every reused chunk is still at the same
+//     place in the output, only the changed chunks are written.  If the
+//     source has errors, the output and its chunk list are removed.
+//     Returns 0 on errors.
+//
+
+int BinascIncremental::compile(const char* source, const char* output) {
+   chunks.clear();
+   oldChunks.clear();
+   errors.clear();
+   errorMessage.clear();
+   writtenBytes  = 0;
+   compiledCount = 0;
+   incrementalQ  = 0;
+
+   int infd = open(source, O_RDONLY);
+   struct stat info;
+   if (infd < 0 || fstat(infd, &info) != 0) {
+      if (infd >= 0) {
+         close(infd);
+      }
+      return fail(string("cannot read source file ") + source);
+   }
+   size_t size = (size_t)info.st_size;
+   const char* text = "";
+   void* mapping = MAP_FAILED;
+   if (size > 0) {
+      mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, infd, 0);
+      if (mapping == MAP_FAILED) {
+         close(infd);
+         return fail(string("cannot map source file ") + source + ": " +
+               strerror(errno));
+      }
+      text = (const char*)mapping;
+   }
+   close(infd);
+
+   string outputName = output;
+   splitChunks(text, size);
+   int previousQ = readChunkList(outputName);
+
+   // match chunks to the last run; compile changed chunks into memory
+   // while the output can still be updated in place
+   map<ulonglong, int> previous;
+   ulonglong offset = 0;
+   int i;
+   for (i=0; i<(int)oldChunks.size(); i++) {
+      oldChunks[i].outputOffset = offset;
+      offset += oldChunks[i].outputLength;
+      if (oldChunks[i].reusableQ) {
+         previous[oldChunks[i].hash] = i;
+      }
+   }
+   ulonglong previousSize = offset;
+   int inPlaceQ = previousQ;
+   int status = 1;
+   offset = 0;
+   for (i=0; i<(int)chunks.size() && status > 0; i++) {
+      SourceChunk& chunk = chunks[i];
+      map<ulonglong, int>::iterator found = previous.find(chunk.hash);
+      if (found != previous.end()) {
+         SourceChunk& old = oldChunks[found->second];
+         chunk.reusedQ        = 1;
+         chunk.reusableQ      = 1;
+         chunk.outputLength   = old.outputLength;
+         chunk.previousOffset = old.outputOffset;
+         if (chunk.previousOffset != offset) {
+            inPlaceQ = 0;
+         }
+      } else if (inPlaceQ) {
+         OutputBuffer memory;
+         status = compileChunk(text, chunk, memory);
+         if (status > 0) {
+            chunk.output.assign((const char*)memory.getData(),
+                  memory.getSize());
+            chunk.compiledQ = 1;
+         }
+      }
+      offset += chunk.outputLength;
+   }
+   if (offset != previousSize) {
+      inPlaceQ = 0;
+   }
+
+   if (status > 0) {
+      if (inPlaceQ) {
+         incrementalQ = 1;
+         status = updateInPlace(outputName);
+      } else {
+         status = rebuild(text, outputName);
+      }
+   }
+   if (status < 0) {
+      // labels or macros are used, so the source cannot be compiled in pieces
+      errors.clear();
+      status = compileWhole(text, size, outputName);
+      unlink((outputName + CHUNK_SUFFIX).c_str());
+   } else if (status > 0) {
+      status = writeChunkList(outputName);
+   }
+
+   if (mapping != MAP_FAILED) {
+      munmap(mapping, size);
+   }
+   if (!status) {
+      unlink(output);
+      unlink((outputName + CHUNK_SUFFIX).c_str());
+   }
+   return status;
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::getErrors -- returns the errors in the source.
+//
+
+const vector<BinascError>& BinascIncremental::getErrors(void) const {
+   return errors;
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::getError -- returns an error which is not in the
+//     source, such as a file which cannot be written, or an empty string.
+//
+
+const char* BinascIncremental::getError(void) const {
+   return errorMessage.c_str();
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::getChunkCount -- returns the number of chunks in
+//     the source.
+//
+
+int BinascIncremental::getChunkCount(void) const {
+   return (int)chunks.size();
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::getCompiledCount -- returns the number of chunks
+//     which had to be compiled.
+//
+
+int BinascIncremental::getCompiledCount(void) const {
+   return compiledCount;
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::getWrittenBytes -- returns the number of bytes which
+//     were written to the output file.
+//
+
+ulonglong BinascIncremental::getWrittenBytes(void) const {
+   return writtenBytes;
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::wasIncremental -- returns true if the last compile
+//     only rewrote the changed parts of the output file.
+//
+
+int BinascIncremental::wasIncremental(void) const {
+   return incrementalQ;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+
+//////////////////////////////
+//
+// BinascIncremental::splitChunks -- divide the source into chunks of
+//     whole lines and hash each chunk.
+//
+
+void BinascIncremental::splitChunks(const char* text, size_t size) {
+   ulonglong seed = getVersionHash();
+   SourceChunk chunk;
+   chunk.offset         = 0;
+   chunk.firstLine      = 1;
+   chunk.outputOffset   = 0;
+   chunk.outputLength   = 0;
+   chunk.previousOffset = 0;
+   chunk.reusableQ      = 0;
+   chunk.reusedQ        = 0;
+   chunk.compiledQ      = 0;
+
+   int lineNumber = 1;
+   size_t position = 0;
+   while (position < size) {
+      const char* newline = (const char*)memchr(text + position, '\n',
+            size - position);
+      size_t ending = newline == NULL ? size : newline - text + 1;
+      size_t length = ending - chunk.offset;
+      ulonglong lineHash = BinascCache::hash(text + position,
+            ending - position);
+      position = ending;
+      lineNumber++;
+
+      if (position < size && (length < CHUNK_MINIMUM ||
+            ((lineHash & CHUNK_MASK) != 0 && length < CHUNK_MAXIMUM))) {
+         continue;
+      }
+      chunk.length = length;
+      chunk.hash   = BinascCache::hash(text + chunk.offset, length, seed);
+      chunks.push_back(chunk);
+      chunk.offset    = position;
+      chunk.firstLine = lineNumber;
+   }
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::readChunkList -- read the chunks of the last run.
+//     The list is only used if the output file has not changed since it
+//     was written.  Returns 0 if there is no usable list.
+//
+
+int BinascIncremental::readChunkList(const string& output) {
+   ifstream input((output + CHUNK_SUFFIX).c_str());
+   struct stat info;
+   if (!input.is_open() || stat(output.c_str(), &info) != 0) {
+      return 0;
+   }
+
+   string marker;
+   ulonglong version;
+   ulonglong size;
+   long long seconds;
+   long long nanoseconds;
+   int count;
+   input >> marker >> hex >> version >> dec >> size >> seconds
+         >> nanoseconds >> count;
+   if (!input || marker != CHUNK_LIST_MARKER ||
+         version != getVersionHash() ||
+         size != (ulonglong)info.st_size ||
+         seconds != (long long)info.st_mtim.tv_sec ||
+         nanoseconds != (long long)info.st_mtim.tv_nsec || count < 0) {
+      return 0;
+   }
+
+   SourceChunk chunk;
+   ulonglong total = 0;
+   int i;
+   for (i=0; i<count; i++) {
+      input >> hex >> chunk.hash >> dec >> chunk.outputLength
+            >> chunk.reusableQ;
+      if (!input) {
+         oldChunks.clear();
+         return 0;
+      }
+      total += chunk.outputLength;
+      oldChunks.push_back(chunk);
+   }
+   if (total != size) {
+      oldChunks.clear();
+      return 0;
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::writeChunkList -- save the chunks of this run next
+//     to the output file, along with the size and time of the output so
+//     that a changed output is not trusted.  Returns 0 on failure.
+//
+
+int BinascIncremental::writeChunkList(const string& output) {
+   struct stat info;
+   if (stat(output.c_str(), &info) != 0) {
+      return fail("cannot read output file " + output);
+   }
+   string listName = output + CHUNK_SUFFIX;
+   ofstream list(listName.c_str());
+   list << CHUNK_LIST_MARKER << ' ' << hex << getVersionHash() << dec << ' '
+        << (ulonglong)info.st_size << ' '
+        << (long long)info.st_mtim.tv_sec << ' '
+        << (long long)info.st_mtim.tv_nsec << ' ' << chunks.size() << '\n';
+   int i;
+   for (i=0; i<(int)chunks.size(); i++) {
+      list << hex << chunks[i].hash << dec << ' ' << chunks[i].outputLength
+           << ' ' << chunks[i].reusableQ << '\n';
+   }
+   list.close();
+   if (!list) {
+      unlink(listName.c_str());
+      return fail("cannot write " + listName);
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::compileChunk -- compile one chunk into out.  Line
+//     numbers of errors are given in the whole source.  Returns 1 if
+//     compiled, 0 on errors, and -1 if the chunk uses labels or defines
+//     macros.
+//
+
+int BinascIncremental::compileChunk(const char* text, SourceChunk& chunk,
+      OutputBuffer& out) {
+   BinascCompiler compiler;
+   compiler.setOutput(out);
+   ulonglong start = out.tell();
+   compiler.compileText(text + chunk.offset, chunk.length);
+   compiler.finish();
+   compiledCount++;
+   if (compiler.usesLabels() || compiler.usesMacros()) {
+      return -1;
+   }
+
+   const vector<BinascError>& chunkErrors = compiler.getErrors();
+   int i;
+   for (i=0; i<(int)chunkErrors.size(); i++) {
+      errors.push_back(chunkErrors[i]);
+      if (errors.back().lineNumber > 0) {
+         errors.back().lineNumber += chunk.firstLine - 1;
+      }
+   }
+   if (!chunkErrors.empty()) {
+      return 0;
+   }
+   chunk.outputLength = out.tell() - start;
+   chunk.reusableQ    = compiler.getIncludedFiles().empty();
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::compileWhole -- compile the source in one piece.
+//     Returns 0 on errors.
+//
+
+int BinascIncremental::compileWhole(const char* text, size_t size,
+      const string& output) {
+   OutputBuffer out;
+   if (!out.open(output.c_str())) {
+      return fail("cannot open output file " + output);
+   }
+   BinascCompiler compiler;
+   compiler.setOutput(out);
+   compiler.compileText(text, size);
+   compiler.finish();
+   out.close();
+   errors = compiler.getErrors();
+   compiledCount = (int)chunks.size();
+   writtenBytes  = out.tell();
+   if (!out.good() && errors.empty()) {
+      return fail(out.getError());
+   }
+   return errors.empty();
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::updateInPlace -- write the output of the changed
+//     chunks over their old output.  Every chunk has the same place and
+//     size as in the last run.  Returns 0 on failure.
+//
+
+int BinascIncremental::updateInPlace(const string& output) {
+   int outfd = open(output.c_str(), O_WRONLY);
+   if (outfd < 0) {
+      return fail("cannot open output file " + output);
+   }
+   ulonglong offset = 0;
+   int i;
+   for (i=0; i<(int)chunks.size(); i++) {
+      SourceChunk& chunk = chunks[i];
+      chunk.outputOffset = offset;
+      offset += chunk.outputLength;
+      if (!chunk.compiledQ) {
+         continue;
+      }
+      const char* data = chunk.output.data();
+      size_t count = chunk.output.size();
+      off_t position = (off_t)chunk.outputOffset;
+      while (count > 0) {
+         ssize_t written = pwrite(outfd, data, count, position);
+         if (written < 0 && errno == EINTR) {
+            continue;
+         }
+         if (written <= 0) {
+            close(outfd);
+            return fail("cannot write output file " + output + ": " +
+                  strerror(errno));
+         }
+         data     += written;
+         count    -= written;
+         position += written;
+      }
+      writtenBytes += chunk.output.size();
+      chunk.output.clear();
+   }
+   if (close(outfd) != 0) {
+      return fail("cannot write output file " + output);
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::rebuild -- write a new output file.  Output of the
+//     last run is copied by the kernel, so the new file is written under
+//     a temporary name first.  Chunks which were not compiled yet are
+//     compiled straight into the file.  Returns 1 if written, 0 on
+//     errors, and -1 if a chunk uses labels or macros.
+//
+
+int BinascIncremental::rebuild(const char* text, const string& output) {
+   int reuseQ = 0;
+   int i;
+   for (i=0; i<(int)chunks.size(); i++) {
+      reuseQ |= chunks[i].reusedQ;
+   }
+
+   string target = output;
+   int oldfd = -1;
+   struct stat info;
+   if (reuseQ) {
+      oldfd = open(output.c_str(), O_RDONLY);
+      if (oldfd < 0 || fstat(oldfd, &info) != 0) {
+         return fail("cannot read output file " + output);
+      }
+      target = output + ".XXXXXX";
+      int tempfd = mkstemp(&target[0]);
+      if (tempfd < 0) {
+         close(oldfd);
+         return fail("cannot create a file next to " + output);
+      }
+      fchmod(tempfd, info.st_mode & 07777);
+      close(tempfd);
+   }
+
+   OutputBuffer out;
+   int status = out.open(target.c_str());
+   if (!status) {
+      fail("cannot open output file " + output);
+   }
+   for (i=0; i<(int)chunks.size() && status > 0; i++) {
+      SourceChunk& chunk = chunks[i];
+      chunk.outputOffset = out.tell();
+      if (chunk.reusedQ) {
+         if (!out.copyFrom(oldfd, chunk.previousOffset,
+               chunk.outputLength)) {
+            status = fail("cannot read output file " + output);
+         }
+      } else if (chunk.compiledQ) {
+         out.write(chunk.output.data(), chunk.output.size());
+         chunk.output.clear();
+      } else {
+         status = compileChunk(text, chunk, out);
+      }
+   }
+   out.close();
+   writtenBytes = out.tell();
+   if (oldfd >= 0) {
+      close(oldfd);
+   }
+   if (status > 0 && !out.good()) {
+      status = fail(out.getError());
+   }
+   if (status > 0 && reuseQ && rename(target.c_str(), output.c_str()) != 0) {
+      status = fail("cannot replace output file " + output);
+   }
+   if (status <= 0 && reuseQ) {
+      unlink(target.c_str());
+   }
+   return status;
+}
+
+
+
+//////////////////////////////
+//
+// BinascIncremental::fail -- remember an error.  Always returns 0.
+//
+
+int BinascIncremental::fail(const string& message) {
+   errorMessage = message;
+   return 0;
+}
+
+
+
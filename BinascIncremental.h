@@ -0,0 +1,105 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 22:03:26 PDT 2026
+// Last Modified: Sun Oct 18 22:03:26 PDT 2026
+// Last Modified: Mon Oct 19 01:14:38 PDT 2026 Macros compile whole
+// Filename:      ...binasc/BinascIncremental.h
+// Syntax:        C++
+//
+// Description:   Compiles a large source file again after small changes
+//                without compiling all of it.  The source is split into
+//                chunks of whole lines, and a list of the chunks with a
+//                hash of each one and the size of its output is kept next
+//                to the output file.  On later runs only the chunks whose
+//                hashes have changed are compiled; the output of the other
+//                chunks is kept in place, or copied by the kernel when
+//                it has moved.
+//
+//                Chunk boundaries are chosen from the contents of the
+//                lines, so adding or removing lines only changes the
+//                chunks around them.  A source which uses labels or
+//                defines macros is compiled whole, because label values
+//                are offsets in the whole output and a macro can be used
+//                in any later chunk.
+//
+
+#ifndef _BINASCINCREMENTAL_H_INCLUDED
+#define _BINASCINCREMENTAL_H_INCLUDED
+
+#include "BinascCompiler.h"
+
+#include <string>
+#include <vector>
+
+// Chunks are at least CHUNK_MINIMUM bytes and at most CHUNK_MAXIMUM bytes,
+// unless a line is longer.  In between, a chunk ends after a line whose
+// hash has the bits of CHUNK_MASK all zero.
+#define CHUNK_MINIMUM  (256 * 1024)
+#define CHUNK_MAXIMUM  (4 * 1024 * 1024)
+#define CHUNK_MASK     0x1fff
+
+// Suffix of the chunk list written next to the output file.
+#define CHUNK_SUFFIX   ".chunks"
+
+
+// A SourceChunk is a run of whole lines of the source and its output.
+class SourceChunk {
+   public:
+      ulonglong      hash;         // hash of the text (and compiler version)
+      size_t         offset;       // location of the text in the source
+      size_t         length;       // number of bytes of text
+      int            firstLine;    // line number of the first line
+      ulonglong      outputOffset; // location of the output
+      ulonglong      outputLength; // number of bytes of output
+      ulonglong      previousOffset; // location of the output last time
+      int            reusableQ;    // output depends only on the text
+      int            reusedQ;      // output is kept from the last run
+      int            compiledQ;    // output is in the output string
+      std::string    output;       // output of a compiled chunk
+};
+
+
+class BinascIncremental {
+   public:
+                     BinascIncremental     (void);
+                    ~BinascIncremental     ();
+
+      int            compile               (const char* source,
+                                            const char* output);
+
+      const std::vector<BinascError>& getErrors (void) const;
+      const char*    getError              (void) const;
+      int            getChunkCount         (void) const;
+      int            getCompiledCount      (void) const;
+      ulonglong      getWrittenBytes       (void) const;
+      int            wasIncremental        (void) const;
+
+   protected:
+      std::vector<SourceChunk> chunks;    // chunks of the current source
+      std::vector<SourceChunk> oldChunks; // chunks of the previous run
+      std::vector<BinascError> errors;    // errors in the source
+      std::string    errorMessage; // error which is not in the source
+      ulonglong      writtenBytes; // bytes of output which were written
+      int            compiledCount; // chunks compiled in this run
+      int            incrementalQ; // output of the last run was reused
+
+      void           splitChunks           (const char* text, size_t size);
+      int            readChunkList         (const std::string& output);
+      int            writeChunkList        (const std::string& output);
+      int            compileChunk          (const char* text,
+                                            SourceChunk& chunk,
+                                            OutputBuffer& out);
+      int            compileWhole          (const char* text, size_t size,
+                                            const std::string& output);
+      int            updateInPlace         (const std::string& output);
+      int            rebuild               (const char* text,
+                                            const std::string& output);
+      int            fail                  (const std::string& message);
+};
+
+
+
+#endif  /* _BINASCINCREMENTAL_H_INCLUDED */
+
+
+
@@ -0,0 +1,449 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 23:46:15 PDT 2026
+// Last Modified: Sun Oct 18 23:46:15 PDT 2026
+// Filename:      ...binasc/BinascListing.cpp
+// Syntax:        C++
+//
+// Description:   A listing file which maps source lines to the bytes
+//                they compiled into.
+//
+
+#include "BinascListing.h"
+#include "ByteCodec.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+//////////////////////////////
+//
+// BinascListing::BinascListing --
+//
+
+BinascListing::BinascListing(void) {
+   lastLine     = 0;
+   nextOffset   = 0;
+   listingFd    = -1;
+   inputBuffer  = NULL;
+   inputStart   = 0;
+   inputEnd     = 0;
+   inputEofQ    = 0;
+   compiledFd   = -1;
+   window       = NULL;
+   windowOffset = 0;
+   windowSize   = 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::~BinascListing --
+//
+
+BinascListing::~BinascListing() {
+   close();
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::open -- start writing a listing file.  Returns 0 if the
+//     file cannot be opened.
+//
+
+int BinascListing::open(const char* filename) {
+   errorMessage.clear();
+   if (!output.open(filename)) {
+      return fail(string("cannot open listing file ") + filename + ": " +
+            strerror(errno));
+   }
+   output.write(LISTING_MAGIC, strlen(LISTING_MAGIC));
+   lastLine   = 0;
+   nextOffset = 0;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::beginSource -- the following lines come from another
+//     source file.  Line numbers start again at 1.
+//
+
+void BinascListing::beginSource(const char* name) {
+   if (!output.is_open()) {
+      return;
+   }
+   size_t length = strlen(name);
+   writeNumber(LISTING_SOURCE);
+   writeNumber(length);
+   output.write(name, length);
+   lastLine = 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::addLine -- record the bytes compiled from a source line.
+//     Lines are expected in order; a line number which goes backwards
+//     starts an unnamed source.
+//
+
+void BinascListing::addLine(int lineNumber, ulonglong offset,
+      ulonglong count) {
+   if (count == 0 || !output.is_open()) {
+      return;
+   }
+   if (lineNumber <= lastLine) {
+      beginSource("");
+   }
+   if (offset != nextOffset) {
+      writeNumber(LISTING_OFFSET);
+      writeNumber(offset);
+   }
+   uchar bytes[20];
+   int length = encodeUleb128((ulonglong)(lineNumber - lastLine) +
+         LISTING_LINE - 1, bytes);
+   length += encodeUleb128(count, bytes + length);
+   output.write(bytes, length);
+   lastLine   = lineNumber;
+   nextOffset = offset + count;
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::close -- finish writing the listing file.
+//
+
+void BinascListing::close(void) {
+   if (!output.is_open()) {
+      return;
+   }
+   output.close();
+   if (!output.good() && errorMessage.empty()) {
+      errorMessage = output.getError();
+   }
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::good -- returns false if the listing could not be
+//     written or read.
+//
+
+int BinascListing::good(void) const {
+   return errorMessage.empty() && output.good();
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::getError -- returns the reason for a failure.
+//
+
+const char* BinascListing::getError(void) const {
+   if (errorMessage.empty()) {
+      return output.getError();
+   }
+   return errorMessage.c_str();
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::render -- print a listing file as text, one line for
+//     each listed source line, giving its output offset in hexadecimal,
+//     the line number and the first bytes it compiled into, which are
+//     read from the compiled file.  If an offset is given, only the line
+//     which produced the byte at that offset is printed.  Returns 0 if
+//     the files cannot be read or the offset is not in the listing.
+//
+
+int BinascListing::render(const char* listingFile, const char* compiledFile,
+      OutputBuffer& out, ulonglong offset) {
+   errorMessage.clear();
+   listingFd = ::open(listingFile, O_RDONLY);
+   if (listingFd < 0) {
+      return fail(string("cannot open listing file ") + listingFile + ": " +
+            strerror(errno));
+   }
+   compiledFd = ::open(compiledFile, O_RDONLY);
+   if (compiledFd < 0) {
+      fail(string("cannot open compiled file ") + compiledFile + ": " +
+            strerror(errno));
+      ::close(listingFd);
+      listingFd = -1;
+      return 0;
+   }
+   inputBuffer  = new uchar[OUTPUTBUFFER_BLOCK];
+   inputStart   = 0;
+   inputEnd     = 0;
+   inputEofQ    = 0;
+   window       = new uchar[OUTPUTBUFFER_BLOCK];
+   windowOffset = 0;
+   windowSize   = 0;
+
+   string source;
+   ulonglong position = 0;
+   ulonglong tag;
+   ulonglong count;
+   int lineNumber = 0;
+   int foundQ = 0;
+   int status = 1;
+   if (!readBytes(source, strlen(LISTING_MAGIC)) || source != LISTING_MAGIC) {
+      status = fail(string(listingFile) + " is not a binasc listing");
+   }
+   source.clear();
+   while (status && !foundQ) {
+      if (inputStart == inputEnd && !fillInput()) {
+         break;   // end of the listing
+      }
+      if (!readNumber(tag)) {
+         status = fail(string("listing file ") + listingFile +
+               " is cut off");
+      } else if (tag == LISTING_SOURCE) {
+         if (!readNumber(count) || !readBytes(source, (size_t)count)) {
+            status = fail(string("listing file ") + listingFile +
+                  " is cut off");
+         }
+         lineNumber = 0;
+         if (status && offset == LISTING_ALL && !source.empty()) {
+            out.write("; ", 2);
+            out.write(source.data(), source.size());
+            out << '\n';
+         }
+      } else if (tag == LISTING_OFFSET) {
+         if (!readNumber(position)) {
+            status = fail(string("listing file ") + listingFile +
+                  " is cut off");
+         }
+      } else if (!readNumber(count)) {
+         status = fail(string("listing file ") + listingFile +
+               " is cut off");
+      } else {
+         lineNumber += (int)(tag - LISTING_LINE + 1);
+         if (offset == LISTING_ALL) {
+            printLine(out, position, lineNumber, count);
+         } else if (offset >= position && offset - position < count) {
+            if (!source.empty()) {
+               out.write("; ", 2);
+               out.write(source.data(), source.size());
+               out << '\n';
+            }
+            printLine(out, position, lineNumber, count);
+            char text[128];
+            int length = snprintf(text, sizeof(text),
+                  "; offset 0x%llx is byte %llu of line %d\n", offset,
+                  offset - position, lineNumber);
+            out.write(text, length);
+            foundQ = 1;
+         }
+         position += count;
+      }
+      if (status && !errorMessage.empty()) {
+         status = 0;   // from printLine()
+      }
+   }
+   if (status && offset != LISTING_ALL && !foundQ) {
+      char text[64];
+      snprintf(text, sizeof(text), "offset 0x%llx is not in the listing",
+            offset);
+      status = fail(text);
+   }
+
+   ::close(listingFd);
+   ::close(compiledFd);
+   listingFd  = -1;
+   compiledFd = -1;
+   delete [] inputBuffer;
+   delete [] window;
+   inputBuffer = NULL;
+   window      = NULL;
+   return status;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+
+//////////////////////////////
+//
+// BinascListing::writeNumber -- add an unsigned LEB128 number to the
+//     listing file.
+//
+
+void BinascListing::writeNumber(ulonglong value) {
+   uchar bytes[10];
+   output.write(bytes, encodeUleb128(value, bytes));
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::readNumber -- read an unsigned LEB128 number from the
+//     listing file.  Returns 0 if the number is cut off.
+//
+
+int BinascListing::readNumber(ulonglong& value) {
+   if (inputEnd - inputStart < 10 && !inputEofQ) {
+      fillInput();
+   }
+   int count = decodeUleb128(inputBuffer + inputStart, inputEnd - inputStart,
+         value);
+   inputStart += count;
+   return count > 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::readBytes -- read count bytes from the listing file into
+//     text.  Returns 0 if the file is too short.
+//
+
+int BinascListing::readBytes(string& text, size_t count) {
+   text.clear();
+   while (count > 0) {
+      if (inputStart == inputEnd && !fillInput()) {
+         return 0;
+      }
+      size_t chunk = inputEnd - inputStart;
+      if (chunk > count) {
+         chunk = count;
+      }
+      text.append((const char*)inputBuffer + inputStart, chunk);
+      inputStart += chunk;
+      count      -= chunk;
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::fillInput -- move the unread bytes of the listing to the
+//     start of the buffer and read more after them.  Returns the number
+//     of unread bytes.
+//
+
+int BinascListing::fillInput(void) {
+   if (inputStart > 0) {
+      memmove(inputBuffer, inputBuffer + inputStart, inputEnd - inputStart);
+      inputEnd  -= inputStart;
+      inputStart = 0;
+   }
+   while (!inputEofQ && inputEnd < OUTPUTBUFFER_BLOCK) {
+      ssize_t status = ::read(listingFd, inputBuffer + inputEnd,
+            OUTPUTBUFFER_BLOCK - inputEnd);
+      if (status < 0 && errno == EINTR) {
+         continue;
+      }
+      if (status <= 0) {
+         inputEofQ = 1;
+         break;
+      }
+      inputEnd += status;
+   }
+   return (int)(inputEnd - inputStart);
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::readCompiled -- returns count bytes of the compiled file
+//     at the given offset, or NULL if the file is too short.  Lines are
+//     read in order, so a block is read at a time.
+//
+
+const uchar* BinascListing::readCompiled(ulonglong offset, size_t count) {
+   if (offset < windowOffset || offset + count > windowOffset + windowSize) {
+      windowOffset = offset;
+      windowSize   = 0;
+      while (windowSize < count) {
+         ssize_t status = pread(compiledFd, window + windowSize,
+               OUTPUTBUFFER_BLOCK - windowSize,
+               (off_t)(windowOffset + windowSize));
+         if (status < 0 && errno == EINTR) {
+            continue;
+         }
+         if (status <= 0) {
+            return NULL;
+         }
+         windowSize += status;
+      }
+   }
+   return window + (offset - windowOffset);
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::printLine -- print the offset, line number and first
+//     bytes of one source line.
+//
+
+void BinascListing::printLine(OutputBuffer& out, ulonglong offset,
+      int lineNumber, ulonglong count) {
+   size_t shown = count > LISTING_BYTES ? LISTING_BYTES : (size_t)count;
+   const uchar* bytes = readCompiled(offset, shown);
+   if (bytes == NULL) {
+      fail("the compiled file is shorter than the listing");
+      return;
+   }
+   static const char hexDigits[] = "0123456789abcdef";
+   char text[128];
+   int length = snprintf(text, sizeof(text), "%08llx %7d ", offset,
+         lineNumber);
+   for (size_t i=0; i<shown; i++) {
+      text[length++] = ' ';
+      text[length++] = hexDigits[bytes[i] >> 4];
+      text[length++] = hexDigits[bytes[i] & 0x0f];
+   }
+   if (count > shown) {
+      length += snprintf(text + length, sizeof(text) - length,
+            " ... (%llu bytes)", count);
+   }
+   text[length++] = '\n';
+   out.write(text, length);
+}
+
+
+
+//////////////////////////////
+//
+// BinascListing::fail -- keep the first error.  Returns 0.
+//
+
+int BinascListing::fail(const string& message) {
+   if (errorMessage.empty()) {
+      errorMessage = message;
+   }
+   return 0;
+}
+
+
+
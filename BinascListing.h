@@ -0,0 +1,96 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 23:46:15 PDT 2026
+// Last Modified: Sun Oct 18 23:46:15 PDT 2026
+// Filename:      ...binasc/BinascListing.h
+// Syntax:        C++
+//
+// Description:   A listing file which records, for each source line, the
+//                offset and number of bytes it compiled into.  The file is
+//                written while compiling and is a few bytes per line: the
+//                offsets follow from the byte counts, and the bytes
+//                themselves are read back from the compiled file when the
+//                listing is printed as text.  A single output offset can
+//                be looked up without printing the rest of the listing.
+//
+//                The file starts with LISTING_MAGIC, followed by records
+//                of unsigned LEB128 numbers.  The first number of a record
+//                is its tag:
+//                   0  = a new source: name length, then the name
+//                   1  = the next line starts at the given offset
+//                   2+ = a line (tag - 1) lines after the previous one,
+//                        followed by its number of bytes
+//                Lines which compile to no bytes are not listed.
+//
+
+#ifndef _BINASCLISTING_H_INCLUDED
+#define _BINASCLISTING_H_INCLUDED
+
+#include "OutputBuffer.h"
+
+#include <string>
+
+#define LISTING_MAGIC     "binasc listing 1\n"
+#define LISTING_SOURCE    0
+#define LISTING_OFFSET    1
+#define LISTING_LINE      2
+
+// render() prints every line unless given an output offset.
+#define LISTING_ALL       (~0ULL)
+
+// Bytes of each line printed by render(); longer lines are shortened.
+#define LISTING_BYTES     16
+
+
+class BinascListing {
+   public:
+                     BinascListing         (void);
+                    ~BinascListing         ();
+
+      int            open                  (const char* filename);
+      void           beginSource           (const char* name);
+      void           addLine               (int lineNumber, ulonglong offset,
+                                            ulonglong count);
+      void           close                 (void);
+      int            good                  (void) const;
+      const char*    getError              (void) const;
+
+      int            render                (const char* listingFile,
+                                            const char* compiledFile,
+                                            OutputBuffer& out,
+                                            ulonglong offset = LISTING_ALL);
+
+   protected:
+      OutputBuffer   output;       // listing file being written
+      std::string    errorMessage; // reason for a failure
+      int            lastLine;     // line number of the last record
+      ulonglong      nextOffset;   // offset following the last record
+
+      // reading the listing and compiled files for render()
+      int            listingFd;    // listing file
+      uchar*         inputBuffer;  // unread part of the listing
+      size_t         inputStart;   // next byte to read in inputBuffer
+      size_t         inputEnd;     // end of the bytes in inputBuffer
+      int            inputEofQ;    // no more bytes in the listing file
+      int            compiledFd;   // compiled file
+      uchar*         window;       // bytes of the compiled file
+      ulonglong      windowOffset; // offset of window in the compiled file
+      size_t         windowSize;   // number of bytes in window
+
+      void           writeNumber           (ulonglong value);
+      int            readNumber            (ulonglong& value);
+      int            readBytes             (std::string& text, size_t count);
+      int            fillInput             (void);
+      const uchar*   readCompiled          (ulonglong offset, size_t count);
+      void           printLine             (OutputBuffer& out,
+                                            ulonglong offset, int lineNumber,
+                                            ulonglong count);
+      int            fail                  (const std::string& message);
+};
+
+
+
+#endif  /* _BINASCLISTING_H_INCLUDED */
+
+
+
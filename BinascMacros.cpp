@@ -0,0 +1,226 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Mon Oct 19 01:14:38 PDT 2026
+// Last Modified: Mon Oct 19 01:14:38 PDT 2026
+// Filename:      ...binasc/BinascMacros.cpp
+// Syntax:        C++
+//
+// Description:   The table of macros defined in binasc text.
+//
+
+#include "BinascMacros.h"
+
+#include <string.h>
+
+using namespace std;
+
+// The hash table is kept at most half full, and starts with this size.
+#define MACRO_TABLE_SIZE 64
+
+
+//////////////////////////////
+//
+// BinascMacros::BinascMacros --
+//
+
+BinascMacros::BinascMacros(void) {
+   // do nothing
+}
+
+
+
+//////////////////////////////
+//
+// BinascMacros::~BinascMacros --
+//
+
+BinascMacros::~BinascMacros() {
+   clear();
+}
+
+
+
+//////////////////////////////
+//
+// BinascMacros::define -- add a macro with no parameters and an empty
+//     body.  Returns NULL if a macro of that name is already defined.
+//
+
+BinascMacro* BinascMacros::define(const char* name, int lineNumber) {
+   if (find(name) != NULL) {
+      return NULL;
+   }
+   BinascMacro* macro = new BinascMacro;
+   macro->name       = storage.copy(name);
+   macro->hash       = hashName(name, macro->nameLength);
+   macro->lineNumber = lineNumber;
+   macro->activeQ    = 0;
+   macros.push_back(macro);
+   insert(macro);
+   return macro;
+}
+
+
+
+//////////////////////////////
+//
+// BinascMacros::addParameter -- add a parameter to a macro.  Returns 0 if
+//     the macro already has a parameter of that name.
+//
+
+int BinascMacros::addParameter(BinascMacro& macro, const char* name) {
+   for (int i=0; i<(int)macro.parameters.size(); i++) {
+      if (strcmp(macro.parameters[i], name) == 0) {
+         return 0;
+      }
+   }
+   macro.parameters.push_back(storage.copy(name));
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascMacros::addWord -- add a word to the current line of a macro
+//     body.  A word which is the name of a parameter stands for the word
+//     given for that parameter.
+//
+
+void BinascMacros::addWord(BinascMacro& macro, const char* word) {
+   MacroWord item;
+   item.text      = NULL;
+   item.length    = 0;
+   item.parameter = -1;
+   for (int i=0; i<(int)macro.parameters.size(); i++) {
+      if (strcmp(macro.parameters[i], word) == 0) {
+         item.parameter = i;
+         break;
+      }
+   }
+   if (item.parameter < 0) {
+      item.text   = storage.copy(word);
+      item.length = strlen(word);
+   }
+   macro.body.push_back(item);
+}
+
+
+
+//////////////////////////////
+//
+// BinascMacros::endLine -- end the current line of a macro body.
+//
+
+void BinascMacros::endLine(BinascMacro& macro) {
+   MacroWord item;
+   item.text      = NULL;
+   item.length    = 0;
+   item.parameter = -1;
+   macro.body.push_back(item);
+}
+
+
+
+//////////////////////////////
+//
+// BinascMacros::find -- returns the macro named by a word, or NULL.
+//
+
+BinascMacro* BinascMacros::find(const char* word) const {
+   if (table.empty()) {
+      return NULL;
+   }
+   size_t length;
+   ulonglong hash = hashName(word, length);
+   size_t mask = table.size() - 1;
+   for (size_t slot = (size_t)hash & mask; table[slot] != NULL;
+         slot = (slot + 1) & mask) {
+      BinascMacro* macro = table[slot];
+      if (macro->hash == hash && macro->nameLength == length &&
+            memcmp(macro->name, word, length) == 0) {
+         return macro;
+      }
+   }
+   return NULL;
+}
+
+
+
+//////////////////////////////
+//
+// BinascMacros::getCount -- returns the number of macros defined.
+//
+
+int BinascMacros::getCount(void) const {
+   return (int)macros.size();
+}
+
+
+
+//////////////////////////////
+//
+// BinascMacros::clear -- remove all of the macros.
+//
+
+void BinascMacros::clear(void) {
+   for (int i=0; i<(int)macros.size(); i++) {
+      delete macros[i];
+   }
+   macros.clear();
+   table.clear();
+   storage.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+
+//////////////////////////////
+//
+// BinascMacros::hashName -- the 64-bit FNV-1a hash of a name, which also
+//     gives the length of the name.
+//
+
+ulonglong BinascMacros::hashName(const char* name, size_t& length) {
+   ulonglong hash = 0xcbf29ce484222325ULL;
+   const char* start = name;
+   while (*name != '\0') {
+      hash ^= (uchar)*name++;
+      hash *= 0x100000001b3ULL;
+   }
+   length = name - start;
+   return hash;
+}
+
+
+
+//////////////////////////////
+//
+// BinascMacros::insert -- add a macro to the hash table, doubling the
+//     table when it becomes half full.
+//
+
+void BinascMacros::insert(BinascMacro* macro) {
+   if (macros.size() * 2 > table.size()) {
+      size_t size = table.empty() ? MACRO_TABLE_SIZE : table.size() * 2;
+      table.assign(size, (BinascMacro*)NULL);
+      for (int i=0; i<(int)macros.size(); i++) {
+         if (macros[i] != macro) {
+            insert(macros[i]);
+         }
+      }
+   }
+   size_t mask = table.size() - 1;
+   size_t slot = (size_t)macro->hash & mask;
+   while (table[slot] != NULL) {
+      slot = (slot + 1) & mask;
+   }
+   table[slot] = macro;
+}
+
+
+
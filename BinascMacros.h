@@ -0,0 +1,79 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Mon Oct 19 01:14:38 PDT 2026
+// Last Modified: Mon Oct 19 01:14:38 PDT 2026
+// Filename:      ...binasc/BinascMacros.h
+// Syntax:        C++
+//
+// Description:   The table of macros defined with #define and #macro in
+//                binasc text.  A macro body is split into words when it
+//                is defined, and each word which names a parameter is
+//                replaced by the parameter's number, so that expanding a
+//                macro only copies words.  Names are stored once in the
+//                table's arena and found through a hash table, so looking
+//                up a word takes the same time however many macros there
+//                are.
+//
+
+#ifndef _BINASCMACROS_H_INCLUDED
+#define _BINASCMACROS_H_INCLUDED
+
+#include "BinascArena.h"
+#include "OutputBuffer.h"
+
+#include <vector>
+
+
+// A MacroWord is one word of a macro body: text to copy, or a parameter
+// to replace with the word given for it.  A word with neither ends a
+// line of the body.
+class MacroWord {
+   public:
+      const char*    text;         // word to copy, or NULL
+      size_t         length;       // number of characters in text
+      int            parameter;    // number of a parameter, or -1
+};
+
+
+class BinascMacro {
+   public:
+      const char*    name;         // name of the macro
+      size_t         nameLength;   // number of characters in the name
+      ulonglong      hash;         // hash of the name
+      int            lineNumber;   // line of the definition
+      int            activeQ;      // the macro is being expanded
+      std::vector<const char*> parameters; // names of the parameters
+      std::vector<MacroWord> body; // words and ends of lines
+};
+
+
+class BinascMacros {
+   public:
+                     BinascMacros          (void);
+                    ~BinascMacros          ();
+
+      BinascMacro*   define                (const char* name, int lineNumber);
+      int            addParameter          (BinascMacro& macro,
+                                            const char* name);
+      void           addWord               (BinascMacro& macro,
+                                            const char* word);
+      void           endLine               (BinascMacro& macro);
+      BinascMacro*   find                  (const char* word) const;
+      int            getCount              (void) const;
+      void           clear                 (void);
+
+   protected:
+      BinascArena    storage;      // names and body words
+      std::vector<BinascMacro*> macros; // in order of definition
+      std::vector<BinascMacro*> table; // hash table, NULL for a free slot
+
+      static ulonglong hashName            (const char* name, size_t& length);
+      void           insert                (BinascMacro* macro);
+};
+
+
+
+#endif  /* _BINASCMACROS_H_INCLUDED */
+
+
+
@@ -0,0 +1,307 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 20:41:07 PDT 2026
+// Last Modified: Sun Oct 18 20:41:07 PDT 2026
+// Last Modified: Sun Oct 18 21:17:45 PDT 2026 Added setCache()
+// Filename:      ...binasc/BinascManifest.cpp
+// Syntax:        C++
+//
+// Description:   Compiles a list of source files, each into its own
+//                output file, on several threads.
+//
+
+#include "BinascManifest.h"
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+
+#include <unistd.h>
+
+using namespace std;
+
+
+//////////////////////////////
+//
+// BinascManifest::BinascManifest --
+//
+
+BinascManifest::BinascManifest(void) {
+   cache = NULL;
+}
+
+
+
+//////////////////////////////
+//
+// BinascManifest::~BinascManifest --
+//
+
+BinascManifest::~BinascManifest() {
+   // do nothing
+}
+
+
+
+//////////////////////////////
+//
+// BinascManifest::read -- read the jobs in a manifest.  Each line gives a
+//     source file and then an output file, separated by spaces or tabs.
+//     Blank lines and lines starting with a semi-colon are skipped.
+//     Returns 0 if the manifest cannot be read or a line is not a job.
+//
+
+int BinascManifest::read(const char* filename) {
+   ifstream input(filename);
+   if (!input.is_open()) {
+      errorMessage = string("cannot open manifest ") + filename;
+      return 0;
+   }
+   return read(input);
+}
+
+
+int BinascManifest::read(istream& input) {
+   errorMessage.clear();
+   string line;
+   int lineNumber = 0;
+   while (getline(input, line)) {
+      lineNumber++;
+      istringstream words(line);
+      ManifestJob job;
+      string extra;
+      if (!(words >> job.source) || job.source[0] == ';') {
+         continue;
+      }
+      if (!(words >> job.output) || ((words >> extra) && extra[0] != ';')) {
+         ostringstream message;
+         message << "line " << lineNumber << " of the manifest must give "
+                 << "a source file and an output file";
+         errorMessage = message.str();
+         return 0;
+      }
+      job.lineNumber   = lineNumber;
+      job.status       = -1;
+      job.cachedQ      = 0;
+      job.milliseconds = 0.0;
+      jobList.push_back(job);
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascManifest::setCache -- copy outputs from a cache of compiled
+//     files when possible, and add new outputs to it.  The cache is not
+//     owned by the manifest.
+//
+
+void BinascManifest::setCache(BinascCache* aCache) {
+   cache = aCache;
+}
+
+
+
+//////////////////////////////
+//
+// BinascManifest::run -- compile every job with the given number of
+//     threads.  Jobs are dealt out to the threads in turn; a thread
+//     takes its own jobs from the front of its queue, and steals from
+//     the back of the other queues once its own is empty.  Returns the
+//     number of jobs which failed.
+//
+
+int BinascManifest::run(int threadCount) {
+   if (threadCount < 1) {
+      threadCount = 1;
+   }
+   if (threadCount > (int)jobList.size()) {
+      threadCount = (int)jobList.size();
+   }
+   if (threadCount == 0) {
+      return 0;
+   }
+
+   JobQueue* queues = new JobQueue[threadCount];
+   int i;
+   for (i=0; i<(int)jobList.size(); i++) {
+      queues[i % threadCount].jobs.push_back(i);
+   }
+
+   vector<thread> threads;
+   for (i=1; i<threadCount; i++) {
+      threads.push_back(thread(&BinascManifest::worker, this, queues,
+            threadCount, i));
+   }
+   worker(queues, threadCount, 0);
+   for (i=0; i<(int)threads.size(); i++) {
+      threads[i].join();
+   }
+   delete [] queues;
+
+   int failures = 0;
+   for (i=0; i<(int)jobList.size(); i++) {
+      if (jobList[i].status != 1) {
+         failures++;
+      }
+   }
+   return failures;
+}
+
+
+
+//////////////////////////////
+//
+// BinascManifest::getJobCount -- returns the number of jobs in the
+//     manifest.
+//
+
+int BinascManifest::getJobCount(void) const {
+   return (int)jobList.size();
+}
+
+
+
+//////////////////////////////
+//
+// BinascManifest::getJob -- returns a job and its result, in the order
+//     of the manifest.
+//
+
+const ManifestJob& BinascManifest::getJob(int index) const {
+   return jobList[index];
+}
+
+
+
+//////////////////////////////
+//
+// BinascManifest::getError -- returns the reason read() failed.
+//
+
+const char* BinascManifest::getError(void) const {
+   return errorMessage.c_str();
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+
+//////////////////////////////
+//
+// BinascManifest::worker -- run jobs until there are none left.
+//
+
+void BinascManifest::worker(JobQueue* queues, int count, int index) {
+   int job;
+   while ((job = nextJob(queues, count, index)) >= 0) {
+      runJob(jobList[job]);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// BinascManifest::nextJob -- take the next job from the thread's own
+//     queue, or else steal one from another queue.  Returns -1 when
+//     every queue is empty.  No jobs are added while threads run, so an
+//     empty queue stays empty.
+//
+
+int BinascManifest::nextJob(JobQueue* queues, int count, int index) {
+   int job = -1;
+   {
+      lock_guard<mutex> guard(queues[index].lock);
+      if (!queues[index].jobs.empty()) {
+         job = queues[index].jobs.front();
+         queues[index].jobs.pop_front();
+         return job;
+      }
+   }
+
+   int i;
+   for (i=1; i<count; i++) {
+      JobQueue& victim = queues[(index + i) % count];
+      lock_guard<mutex> guard(victim.lock);
+      if (!victim.jobs.empty()) {
+         job = victim.jobs.back();
+         victim.jobs.pop_back();
+         return job;
+      }
+   }
+   return -1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascManifest::runJob -- compile one source file, or copy its output
+//     from the cache.  The output file is removed if the source has
+//     errors, so that a failed job does not leave a file which looks up
+//     to date.  Outputs which depend on incbin files are not cached.
+//
+
+void BinascManifest::runJob(ManifestJob& job) {
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   job.status  = 0;
+   job.cachedQ = 0;
+   job.errors.clear();
+
+   BinascError error;
+   error.lineNumber = 0;
+   vector<string> inputs(1);
+   ifstream input(job.source.c_str(), ios::binary);
+   OutputBuffer out;
+   if (!input.is_open()) {
+      error.message = "cannot open source file " + job.source;
+      job.errors.push_back(error);
+   } else if (!out.open(job.output.c_str())) {
+      error.message = "cannot open output file " + job.output;
+      job.errors.push_back(error);
+   } else {
+      ostringstream text;
+      text << input.rdbuf();
+      inputs[0] = text.str();
+      ulonglong key = 0;
+      if (cache != NULL) {
+         key = cache->getKey(inputs);
+         job.cachedQ = cache->fetch(key, out);
+      }
+      BinascCompiler compiler;
+      if (!job.cachedQ) {
+         compiler.setOutput(out);
+         compiler.compileText(inputs[0].data(), inputs[0].size());
+         compiler.finish();
+         job.errors = compiler.getErrors();
+      }
+      out.close();
+      if (!out.good() && job.errors.empty()) {
+         error.message = out.getError();
+         job.errors.push_back(error);
+      }
+      if (!job.errors.empty()) {
+         unlink(job.output.c_str());
+      } else {
+         job.status = 1;
+         if (cache != NULL && !job.cachedQ &&
+               compiler.getIncludedFiles().empty()) {
+            cache->store(key, job.output.c_str());
+         }
+      }
+   }
+
+   chrono::duration<double, milli> elapsed = chrono::steady_clock::now()
+         - start;
+   job.milliseconds = elapsed.count();
+}
+
+
+
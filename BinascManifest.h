@@ -0,0 +1,81 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 20:41:07 PDT 2026
+// Last Modified: Sun Oct 18 20:41:07 PDT 2026
+// Last Modified: Sun Oct 18 21:17:45 PDT 2026 Added setCache()
+// Filename:      ...binasc/BinascManifest.h
+// Syntax:        C++
+//
+// Description:   Compiles a list of source files, each into its own
+//                output file, on several threads.  The list is read from
+//                a manifest which has a source and an output file name
+//                on each line.  Every thread has its own queue of jobs,
+//                and a thread with an empty queue takes jobs from the
+//                others, so that a few slow jobs do not hold up the rest.
+//
+
+#ifndef _BINASCMANIFEST_H_INCLUDED
+#define _BINASCMANIFEST_H_INCLUDED
+
+#include "BinascCompiler.h"
+#include "BinascCache.h"
+
+#include <istream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+
+// A ManifestJob is one line of a manifest, and the result of compiling it.
+class ManifestJob {
+   public:
+      std::string    source;       // file to compile
+      std::string    output;       // file to write
+      int            lineNumber;   // line of the job in the manifest
+      int            status;       // 1 if compiled, 0 if not, -1 if not run
+      int            cachedQ;      // output was copied from the cache
+      double         milliseconds; // time taken to compile
+      std::vector<BinascError> errors; // errors in the source
+};
+
+
+class BinascManifest {
+   public:
+                     BinascManifest        (void);
+                    ~BinascManifest        ();
+
+      int            read                  (const char* filename);
+      int            read                  (std::istream& input);
+      void           setCache              (BinascCache* cache);
+      int            run                   (int threadCount);
+
+      int            getJobCount           (void) const;
+      const ManifestJob& getJob            (int index) const;
+      const char*    getError              (void) const;
+
+   protected:
+      // A JobQueue holds the indexes of jobs waiting for one thread.
+      class JobQueue {
+         public:
+            std::mutex      lock;
+            std::deque<int> jobs;
+      };
+
+      std::vector<ManifestJob> jobList; // jobs in manifest order
+      std::string    errorMessage; // reason read() failed
+      BinascCache*   cache;        // compiled files, or NULL
+
+      void           worker                (JobQueue* queues, int count,
+                                            int index);
+      int            nextJob               (JobQueue* queues, int count,
+                                            int index);
+      void           runJob                (ManifestJob& job);
+};
+
+
+
+#endif  /* _BINASCMANIFEST_H_INCLUDED */
+
+
+
@@ -0,0 +1,148 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 19:58:31 PDT 2026
+// Last Modified: Sun Oct 18 19:58:31 PDT 2026
+// Filename:      ...binasc/BinascProtocol.cpp
+// Syntax:        C++
+//
+// Description:   Frames which are passed between a binasc server and its
+//                clients on a Unix domain socket.
+//
+
+#include "BinascProtocol.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#ifndef MSG_NOSIGNAL
+   #define MSG_NOSIGNAL 0
+#endif
+
+using namespace std;
+
+
+//////////////////////////////
+//
+// storeFrameInt -- store a number as four big-endian bytes.
+//
+
+void storeFrameInt(int value, uchar* output) {
+   unsigned int bits = (unsigned int)value;
+   output[0] = (uchar)(bits >> 24);
+   output[1] = (uchar)(bits >> 16);
+   output[2] = (uchar)(bits >> 8);
+   output[3] = (uchar)bits;
+}
+
+
+
+//////////////////////////////
+//
+// loadFrameInt -- read a number stored by storeFrameInt().
+//
+
+int loadFrameInt(const uchar* input) {
+   return (int)(((unsigned int)input[0] << 24) |
+                ((unsigned int)input[1] << 16) |
+                ((unsigned int)input[2] << 8)  |
+                 (unsigned int)input[3]);
+}
+
+
+
+//////////////////////////////
+//
+// writeFrame -- send a frame.  The header and the data are given to the
+//     kernel together.  Returns 0 if the frame could not be sent.
+//
+
+int writeFrame(int fd, int type, const void* data, size_t count) {
+   if (count > FRAME_LIMIT) {
+      return 0;
+   }
+   uchar header[5];
+   header[0] = (uchar)type;
+   storeFrameInt((int)count, header + 1);
+
+   struct iovec parts[2];
+   parts[0].iov_base = header;
+   parts[0].iov_len  = sizeof(header);
+   parts[1].iov_base = (void*)data;
+   parts[1].iov_len  = count;
+   struct iovec* part = parts;
+   int partCount = count > 0 ? 2 : 1;
+
+   while (partCount > 0) {
+      struct msghdr message = {};
+      message.msg_iov    = part;
+      message.msg_iovlen = partCount;
+      ssize_t written = sendmsg(fd, &message, MSG_NOSIGNAL);
+      if (written < 0) {
+         if (errno == EINTR) {
+            continue;
+         }
+         return 0;
+      }
+      while (partCount > 0 && (size_t)written >= part->iov_len) {
+         written -= part->iov_len;
+         part++;
+         partCount--;
+      }
+      if (partCount > 0) {
+         part->iov_base = (uchar*)part->iov_base + written;
+         part->iov_len -= written;
+      }
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// readBytes -- read exactly count bytes.  Returns 0 at the end of the
+//     connection or on an error.
+//
+
+static int readBytes(int fd, void* output, size_t count) {
+   uchar* position = (uchar*)output;
+   while (count > 0) {
+      ssize_t got = read(fd, position, count);
+      if (got < 0 && errno == EINTR) {
+         continue;
+      }
+      if (got <= 0) {
+         return 0;
+      }
+      position += got;
+      count    -= got;
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// readFrame -- receive the next frame.  Returns 0 at the end of the
+//     connection, on an error, or if the frame is longer than FRAME_LIMIT.
+//
+
+int readFrame(int fd, int& type, string& data) {
+   uchar header[5];
+   if (!readBytes(fd, header, sizeof(header))) {
+      return 0;
+   }
+   int count = loadFrameInt(header + 1);
+   if (count < 0 || count > FRAME_LIMIT) {
+      return 0;
+   }
+   type = header[0];
+   data.resize(count);
+   return count == 0 || readBytes(fd, &data[0], count);
+}
+
+
+
@@ -0,0 +1,59 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 19:58:31 PDT 2026
+// Last Modified: Sun Oct 18 19:58:31 PDT 2026
+// Last Modified: Mon Oct 19 05:20:44 PDT 2026 Threads and merge listed
+// Filename:      ...binasc/BinascProtocol.h
+// Syntax:        C++
+//
+// Description:   Frames which are passed between a binasc server and its
+//                clients on a Unix domain socket.  Every frame is a type
+//                byte and a 4-byte big-endian length, followed by that
+//                many bytes of data.
+//
+//                A request is a compile or listing frame, then the text
+//                of each input as data frames with an end-of-input frame
+//                after each one, then an end-of-request frame.  The reply
+//                is output frames, then error frames, then a status
+//                frame.  Any number of requests can be sent on one
+//                connection.
+//
+
+#ifndef _BINASCPROTOCOL_H_INCLUDED
+#define _BINASCPROTOCOL_H_INCLUDED
+
+#include <stddef.h>
+#include <string>
+
+typedef unsigned char uchar;
+
+// Frames sent by a client:
+#define FRAME_COMPILE     'C'  // start of a compile: 1 byte, check only flag
+#define FRAME_LIST        'L'  // start of a listing: the six BinascFormat
+                               // fields as 4-byte integers
+#define FRAME_INPUT       'T'  // part of the current input
+#define FRAME_INPUT_END   'F'  // end of the current input
+#define FRAME_REQUEST_END 'X'  // end of the request
+
+// Frames sent by a server:
+#define FRAME_OUTPUT      'D'  // compiled bytes or listing text
+#define FRAME_ERROR       'E'  // 4-byte line number, token, 0, message
+#define FRAME_MESSAGE     'M'  // error which is not in the input text
+#define FRAME_STATUS      'S'  // 4-byte error count; end of the reply
+
+// Largest frame which is accepted.  Inputs are sent in smaller pieces.
+#define FRAME_LIMIT       (16 * 1024 * 1024)
+
+
+int      writeFrame            (int fd, int type, const void* data,
+                                size_t count);
+int      readFrame             (int fd, int& type, std::string& data);
+
+void     storeFrameInt         (int value, uchar* output);
+int      loadFrameInt          (const uchar* input);
+
+
+#endif  /* _BINASCPROTOCOL_H_INCLUDED */
+
+
+
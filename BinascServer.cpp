@@ -0,0 +1,465 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 19:58:31 PDT 2026
+// Last Modified: Sun Oct 18 19:58:31 PDT 2026
+// Last Modified: Mon Oct 19 05:20:44 PDT 2026 Read threads and merge
+// Last Modified: Mon Oct 19 07:05:33 PDT 2026 Listing formats checked
+// Last Modified: Mon Oct 19 07:18:46 PDT 2026 Added setRequestLimit()
+// Filename:      ...binasc/BinascServer.cpp
+// Syntax:        C++
+//
+// Description:   Compiles and lists files for clients which connect on a
+//                Unix domain socket.
+//
+
+#include "BinascServer.h"
+#include "BinascCompiler.h"
+#include "BinascFormatter.h"
+
+#include <thread>
+
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+using namespace std;
+
+
+//////////////////////////////
+//
+// BinascServer::BinascServer --
+//
+
+BinascServer::BinascServer(void) {
+   listenfd     = -1;
+   requestLimit = SERVER_REQUEST_LIMIT;
+}
+
+
+
+//////////////////////////////
+//
+// BinascServer::~BinascServer --
+//
+
+BinascServer::~BinascServer() {
+   close();
+}
+
+
+
+//////////////////////////////
+//
+// BinascServer::open -- create a socket at the given path and listen on
+//     it.  A socket left behind by an earlier server is removed, but
+//     any other kind of file is not.  Returns 0 on failure.
+//
+
+int BinascServer::open(const char* path) {
+   close();
+   errorMessage.clear();
+
+   struct sockaddr_un address = {};
+   address.sun_family = AF_UNIX;
+   if (strlen(path) >= sizeof(address.sun_path)) {
+      return fail(string("socket path is too long: ") + path);
+   }
+   strcpy(address.sun_path, path);
+
+   struct stat info;
+   if (lstat(path, &info) == 0) {
+      if (!S_ISSOCK(info.st_mode)) {
+         return fail(string("file is in the way of the socket: ") + path);
+      }
+      unlink(path);
+   }
+
+   listenfd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (listenfd < 0) {
+      return fail(string("cannot create socket: ") + strerror(errno));
+   }
+   if (bind(listenfd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+         listen(listenfd, SOMAXCONN) != 0) {
+      int problem = errno;
+      ::close(listenfd);
+      listenfd = -1;
+      return fail(string("cannot listen on ") + path + ": " +
+            strerror(problem));
+   }
+   socketPath = path;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// BinascServer::run -- accept connections and serve them with the given
+//     number of threads.  Only returns if the socket fails, and then
+//     returns 0 after the connections already accepted are finished.
+//
+
+int BinascServer::run(int threadCount) {
+   if (listenfd < 0) {
+      return fail("server socket is not open");
+   }
+   if (threadCount < 1) {
+      threadCount = 1;
+   }
+   // a client which goes away should not stop the server
+   signal(SIGPIPE, SIG_IGN);
+
+   vector<thread> threads;
+   int i;
+   for (i=0; i<threadCount; i++) {
+      threads.push_back(thread(&BinascServer::worker, this));
+   }
+
+   while (1) {
+      int client = accept(listenfd, NULL, NULL);
+      if (client < 0) {
+         if (errno == EINTR || errno == ECONNABORTED) {
+            continue;
+         }
+         fail(string("cannot accept connections: ") + strerror(errno));
+         break;
+      }
+      lock_guard<mutex> guard(queueLock);
+      waiting.push_back(client);
+      queueReady.notify_one();
+   }
+
+   // -1 tells a worker to stop
+   {
+      lock_guard<mutex> guard(queueLock);
+      for (i=0; i<threadCount; i++) {
+         waiting.push_back(-1);
+      }
+      queueReady.notify_all();
+   }
+   for (i=0; i<threadCount; i++) {
+      threads[i].join();
+   }
+   return 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascServer::close -- stop listening and remove the socket file.
+//
+
+void BinascServer::close(void) {
+   if (listenfd < 0) {
+      return;
+   }
+   ::close(listenfd);
+   listenfd = -1;
+   unlink(socketPath.c_str());
+   socketPath.clear();
+}
+
+
+
+//////////////////////////////
+//
+// BinascServer::setRequestLimit -- set the most input bytes which one
+//     request may send.  Larger requests are read and thrown away, and
+//     answered with an error.
+//
+
+void BinascServer::setRequestLimit(ulonglong bytes) {
+   requestLimit = bytes;
+}
+
+
+
+//////////////////////////////
+//
+// BinascServer::getError -- returns the reason open() or run() failed.
+//
+
+const char* BinascServer::getError(void) const {
+   return errorMessage.c_str();
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+
+//////////////////////////////
+//
+// BinascServer::worker -- serve connections from the queue until told
+//     to stop.
+//
+
+void BinascServer::worker(void) {
+   while (1) {
+      int client;
+      {
+         unique_lock<mutex> guard(queueLock);
+         queueReady.wait(guard, [this] { return !waiting.empty(); });
+         client = waiting.front();
+         waiting.pop_front();
+      }
+      if (client < 0) {
+         return;
+      }
+      serveConnection(client);
+      ::close(client);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// BinascServer::serveConnection -- answer requests until the client
+//     closes the connection or sends something which is not a request.
+//
+
+void BinascServer::serveConnection(int fd) {
+   while (serveRequest(fd)) {
+      // next request on the same connection
+   }
+}
+
+
+
+//////////////////////////////
+//
+// BinascServer::serveRequest -- read one request and send its reply.
+//     All of the inputs are read before any output is sent, so that a
+//     client does not have to read and write at the same time.  Returns
+//     0 if the connection should be closed.
+//
+
+int BinascServer::serveRequest(int fd) {
+   int type;
+   string header;
+   if (!readFrame(fd, type, header)) {
+      return 0;
+   }
+
+   BinascFormat format;
+   string refusal;
+   int checkQ = 0;
+   if (type == FRAME_COMPILE && header.size() == 1) {
+      checkQ = header[0];
+   } else if (type == FRAME_LIST && header.size() == 24) {
+      const uchar* fields = (const uchar*)header.data();
+      format.style        = loadFrameInt(fields);
+      format.bytesPerLine = loadFrameInt(fields + 4);
+      format.wrap         = loadFrameInt(fields + 8);
+      format.commentQ     = loadFrameInt(fields + 12);
+      format.threads      = loadFrameInt(fields + 16);
+      format.mergeQ       = loadFrameInt(fields + 20);
+      const char* formatError = checkFormat(format);
+      if (formatError != NULL) {
+         refusal = formatError;
+      }
+   } else {
+      return 0;
+   }
+
+   vector<string> inputs;
+   int tooLargeQ = 0;
+   if (!readInputs(fd, inputs, tooLargeQ)) {
+      return 0;
+   }
+   if (tooLargeQ) {
+      refusal = "request is larger than the server limit of " +
+            to_string(requestLimit) + " bytes";
+   }
+
+   OutputBuffer out;
+   if (checkQ) {
+      out.discard();
+   } else {
+      out.open(sendOutput, &fd);
+   }
+   int status = 0;
+   int i;
+
+   if (!refusal.empty()) {
+      out.close();
+      status = 1;
+      if (!writeFrame(fd, FRAME_MESSAGE, refusal.data(), refusal.size())) {
+         return 0;
+      }
+   } else if (type == FRAME_COMPILE) {
+      BinascCompiler compiler;
+      compiler.setOutput(out);
+      compiler.setKeepGoing(checkQ);
+      for (i=0; i<(int)inputs.size(); i++) {
+         if (!compiler.compileText(inputs[i].data(), inputs[i].size()) &&
+               !checkQ) {
+            break;
+         }
+      }
+      compiler.finish();
+      out.close();
+
+      const vector<BinascError>& errors = compiler.getErrors();
+      for (i=0; i<(int)errors.size(); i++) {
+         string data(4, '\0');
+         storeFrameInt(errors[i].lineNumber, (uchar*)&data[0]);
+         data += errors[i].token;
+         data += '\0';
+         data += errors[i].message;
+         if (!writeFrame(fd, FRAME_ERROR, data.data(), data.size())) {
+            return 0;
+         }
+      }
+      status = (int)errors.size();
+   } else {
+      BinascFormatter formatter;
+      formatter.setFormat(format);
+      for (i=0; i<(int)inputs.size(); i++) {
+         if (!formatter.format((const uchar*)inputs[i].data(),
+               inputs[i].size(), out)) {
+            status = 1;
+            break;
+         }
+      }
+      out.close();
+      if (status) {
+         const char* message = formatter.getError();
+         if (!writeFrame(fd, FRAME_MESSAGE, message, strlen(message))) {
+            return 0;
+         }
+      }
+   }
+
+   if (!out.good()) {
+      // the client went away while the output was being sent
+      return 0;
+   }
+   uchar count[4];
+   storeFrameInt(status, count);
+   return writeFrame(fd, FRAME_STATUS, count, sizeof(count));
+}
+
+
+
+//////////////////////////////
+//
+// BinascServer::readInputs -- read the inputs of a request, up to the
+//     end-of-request frame.  Once the inputs add up to more than the
+//     request limit, they are cleared, the rest of the request is read
+//     without keeping it, and tooLargeQ is set.  Returns 0 if the request
+//     is cut off or contains an unknown frame.
+//
+
+int BinascServer::readInputs(int fd, vector<string>& inputs,
+      int& tooLargeQ) {
+   string current;
+   string data;
+   ulonglong total = 0;
+   int type;
+   tooLargeQ = 0;
+   while (readFrame(fd, type, data)) {
+      switch (type) {
+         case FRAME_INPUT:
+            total += data.size();
+            if (total > requestLimit) {
+               if (!tooLargeQ) {
+                  tooLargeQ = 1;
+                  inputs.clear();
+                  string().swap(current);
+               }
+            } else {
+               current += data;
+            }
+            break;
+         case FRAME_INPUT_END:
+            if (!tooLargeQ) {
+               inputs.push_back(string());
+               inputs.back().swap(current);
+            }
+            break;
+         case FRAME_REQUEST_END:
+            return 1;
+         default:
+            return 0;
+      }
+   }
+   return 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascServer::checkFormat -- check the listing format sent by a client.
+//     Too many threads are cut down to FORMAT_THREADS_MAX.  Returns NULL
+//     if the format can be used, or else the reason it cannot.
+//
+
+const char* BinascServer::checkFormat(BinascFormat& format) {
+   if (format.style < FORMAT_BOTH || format.style > FORMAT_MIDI) {
+      return "unknown listing style";
+   }
+   if (format.bytesPerLine < 1) {
+      return "bytes per line must be at least 1";
+   }
+   if (format.wrap < 1) {
+      return "wrap length must be at least 1";
+   }
+   if (format.threads < 1) {
+      return "thread count must be at least 1";
+   }
+   if (format.commentQ < 0 || format.commentQ > 1 ||
+         format.mergeQ < 0 || format.mergeQ > 1) {
+      return "unknown listing flag";
+   }
+   if (format.threads > FORMAT_THREADS_MAX) {
+      format.threads = FORMAT_THREADS_MAX;
+   }
+   return NULL;
+}
+
+
+
+//////////////////////////////
+//
+// BinascServer::fail -- remember an error.  Always returns 0.
+//
+
+int BinascServer::fail(const string& message) {
+   errorMessage = message;
+   return 0;
+}
+
+
+
+//////////////////////////////
+//
+// BinascServer::sendOutput -- output sink which sends each block of
+//     output to the client.
+//
+
+int BinascServer::sendOutput(const uchar* data, size_t count,
+      void* userData) {
+   int fd = *(int*)userData;
+   while (count > 0) {
+      size_t size = count < FRAME_LIMIT ? count : FRAME_LIMIT;
+      if (!writeFrame(fd, FRAME_OUTPUT, data, size)) {
+         return 0;
+      }
+      data  += size;
+      count -= size;
+   }
+   return 1;
+}
+
+
+
@@ -0,0 +1,71 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 19:58:31 PDT 2026
+// Last Modified: Sun Oct 18 19:58:31 PDT 2026
+// Last Modified: Mon Oct 19 07:05:33 PDT 2026 Listing formats checked
+// Last Modified: Mon Oct 19 07:18:46 PDT 2026 Added setRequestLimit()
+// Filename:      ...binasc/BinascServer.h
+// Syntax:        C++
+//
+// Description:   Compiles and lists files for clients which connect on a
+//                Unix domain socket, so that one process can do the work
+//                of many runs of binasc.  Connections are handled by a
+//                fixed set of threads, each with its own compiler or
+//                formatter for every request.  Output is sent back in
+//                blocks while it is made (see BinascProtocol.h).
+//
+
+#ifndef _BINASCSERVER_H_INCLUDED
+#define _BINASCSERVER_H_INCLUDED
+
+#include "BinascProtocol.h"
+#include "BinascFormatter.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+// Default for the most input bytes which one request may send.
+#define SERVER_REQUEST_LIMIT  (256ULL * 1024 * 1024)
+
+
+class BinascServer {
+   public:
+                     BinascServer          (void);
+                    ~BinascServer          ();
+
+      int            open                  (const char* path);
+      int            run                   (int threadCount);
+      void           close                 (void);
+      void           setRequestLimit       (ulonglong bytes);
+      const char*    getError              (void) const;
+
+   protected:
+      int            listenfd;     // listening socket, or -1
+      std::string    socketPath;   // file name of the socket
+      std::string    errorMessage; // reason open() or run() failed
+      std::mutex     queueLock;    // guards waiting
+      std::condition_variable queueReady; // signalled for new connections
+      std::deque<int> waiting;     // accepted connections not yet served
+      ulonglong      requestLimit; // most input bytes in one request
+
+      void           worker                (void);
+      void           serveConnection       (int fd);
+      int            serveRequest          (int fd);
+      int            readInputs            (int fd,
+                                            std::vector<std::string>& inputs,
+                                            int& tooLargeQ);
+      int            fail                  (const std::string& message);
+      static const char* checkFormat       (BinascFormat& format);
+      static int     sendOutput            (const uchar* data, size_t count,
+                                            void* userData);
+};
+
+
+
+#endif  /* _BINASCSERVER_H_INCLUDED */
+
+
+
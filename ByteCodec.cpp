@@ -0,0 +1,587 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 14:25:51 PDT 2026
+// Last Modified: Sun Oct 18 16:03:19 PDT 2026 Added number encoders
+// Last Modified: Sun Oct 18 16:48:52 PDT 2026 Added VLV and LEB128 numbers
+// Last Modified: Mon Oct 19 07:31:20 PDT 2026 Long LEB128 reads checked
+// Filename:      ...binasc/ByteCodec.cpp
+// Syntax:        C++
+//
+// Description:   Functions for converting between bytes and their text
+//                encodings in bulk.  Hexadecimal text is decoded eight
+//                characters at a time inside of 64-bit words.  Numbers
+//                are stored by encoders which are generated for every
+//                byte count and byte order at compile time.
+//                Variable-length numbers are converted a word at a time
+//                by scattering or gathering their 7-bit groups.
+//
+
+#include "ByteCodec.h"
+
+#include <string.h>
+
+#ifdef __BMI2__
+   #include <immintrin.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+   #define BYTECODEC_SWAR
+   #define BYTECODEC_HOST_LITTLE 1
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+   #define BYTECODEC_HOST_LITTLE 0
+#endif
+
+#define ONES  0x0101010101010101ULL
+#define HIGHS 0x8080808080808080ULL
+#define LOWS  0x7f7f7f7f7f7f7f7fULL
+
+
+//////////////////////////////
+//
+// hexNibble -- returns the value of a hexadecimal digit, or a number
+//     with bit 4 set if the character is not a hexadecimal digit.
+//
+
+static inline uchar hexNibble(uchar ch) {
+   uchar lower = ch | 0x20;
+   if (ch >= '0' && ch <= '9') {
+      return ch - '0';
+   }
+   if (lower >= 'a' && lower <= 'f') {
+      return lower - 'a' + 10;
+   }
+   return 0x10;
+}
+
+
+
+#ifdef BYTECODEC_SWAR
+
+//////////////////////////////
+//
+// inRange -- returns the high bit set in each byte of v which is in
+//     the range from low to high.  All bytes must be less than 0x80.
+//
+
+static inline ulonglong inRange(ulonglong v, uchar low, uchar high) {
+   ulonglong atLeast = v + ONES * (0x80 - low);
+   ulonglong above   = v + ONES * (0x7f - high);
+   return atLeast & ~above & HIGHS;
+}
+
+#endif
+
+
+
+//////////////////////////////
+//
+// decodeHex -- decode length hexadecimal digits into length/2 bytes.
+//     Returns 0 if length is odd or if there are any invalid characters.
+//     Each group of eight digits is checked and converted within a
+//     64-bit word, and errors are only tested once at the end.
+//
+
+int decodeHex(const char* text, size_t length, uchar* output) {
+   if (length % 2) {
+      return 0;
+   }
+   size_t i = 0;
+   ulonglong bad = 0;
+
+#ifdef BYTECODEC_SWAR
+   for ( ; i + 8 <= length; i += 8) {
+      ulonglong v;
+      memcpy(&v, text + i, 8);
+      ulonglong lower = v | (ONES * 0x20);
+      ulonglong valid = inRange(v & ~HIGHS, '0', '9')
+                      | inRange(lower & ~HIGHS, 'a', 'f');
+      bad |= (v & HIGHS) | (~valid & HIGHS);
+
+      // digit value = low nibble, plus 9 for letters (which have bit 6 set)
+      ulonglong nibbles = (v & (ONES * 0x0f)) + ((v >> 6) & ONES) * 9;
+      // join pairs of nibbles into bytes, then pack the bytes together
+      ulonglong bytes = ((nibbles << 4) | (nibbles >> 8))
+                      & 0x00ff00ff00ff00ffULL;
+      bytes = (bytes | (bytes >> 8))  & 0x0000ffff0000ffffULL;
+      bytes = (bytes | (bytes >> 16)) & 0x00000000ffffffffULL;
+      memcpy(output + i / 2, &bytes, 4);
+   }
+#endif
+
+   for ( ; i < length; i += 2) {
+      uchar high = hexNibble(text[i]);
+      uchar low  = hexNibble(text[i+1]);
+      bad |= (high | low) & 0x10;
+      output[i / 2] = (uchar)((high << 4) | (low & 0x0f));
+   }
+
+   return bad == 0;
+}
+
+
+
+//////////////////////////////
+//
+// getBase64DecodedSize -- returns the number of bytes which the base64
+//     text will decode into.
+//
+
+size_t getBase64DecodedSize(const char* text, size_t length) {
+   if (length >= 1 && text[length - 1] == '=') {
+      length--;
+      if (length >= 1 && text[length - 1] == '=') {
+         length--;
+      }
+   }
+   size_t extra = length % 4;
+   return (length / 4) * 3 + (extra > 1 ? extra - 1 : 0);
+}
+
+
+
+//////////////////////////////
+//
+// decodeBase64 -- decode base64 text, which may end with one or two '='
+//     padding characters or leave them off.  Each group of four
+//     characters is decoded through a lookup table with no branches,
+//     and errors are checked once at the end.  Returns 0 if the text
+//     is not valid base64.
+//
+
+int decodeBase64(const char* text, size_t length, uchar* output) {
+   static uchar table[256];
+   static int   tableQ = 0;
+   if (!tableQ) {
+      const char* alphabet =
+         "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+      memset(table, 0x80, sizeof(table));
+      int i;
+      for (i=0; i<64; i++) {
+         table[(uchar)alphabet[i]] = (uchar)i;
+      }
+      tableQ = 1;
+   }
+
+   if (length >= 1 && text[length - 1] == '=') {
+      length--;
+      if (length >= 1 && text[length - 1] == '=') {
+         length--;
+      }
+   }
+   if (length % 4 == 1) {
+      return 0;
+   }
+
+   const uchar* in = (const uchar*)text;
+   uchar* out = output;
+   uchar bad = 0;
+   size_t i;
+   for (i=0; i + 4 <= length; i += 4) {
+      uchar a = table[in[i]];
+      uchar b = table[in[i+1]];
+      uchar c = table[in[i+2]];
+      uchar d = table[in[i+3]];
+      bad |= a | b | c | d;
+      unsigned int group = (a << 18) | (b << 12) | (c << 6) | d;
+      out[0] = (uchar)(group >> 16);
+      out[1] = (uchar)(group >> 8);
+      out[2] = (uchar)group;
+      out += 3;
+   }
+
+   // two or three characters left over make one or two bytes
+   size_t extra = length - i;
+   if (extra > 0) {
+      uchar a = table[in[i]];
+      uchar b = table[in[i+1]];
+      uchar c = extra > 2 ? table[in[i+2]] : 0;
+      bad |= a | b | c;
+      unsigned int group = (a << 18) | (b << 12) | (c << 6);
+      *out++ = (uchar)(group >> 16);
+      if (extra > 2) {
+         *out++ = (uchar)(group >> 8);
+      }
+   }
+
+   return (bad & 0x80) == 0;
+}
+
+
+
+//////////////////////////////
+//
+// encodeNumber -- store the lowest WIDTH bytes of value.  The byte order
+//     is a template parameter, so when the host byte order is known the
+//     store is a single memcpy with any byte swap done by a builtin.
+//     Floats arrive as the bits of a double and are narrowed first.
+//
+
+template<int WIDTH, int LITTLE, int TYPE>
+static void encodeNumber(ulonglong value, uchar* output) {
+   if (TYPE == NUMBER_FLOAT && WIDTH == 4) {
+      double number;
+      memcpy(&number, &value, 8);
+      float narrow = (float)number;
+      unsigned int bits;
+      memcpy(&bits, &narrow, 4);
+      value = bits;
+   }
+
+#ifdef BYTECODEC_HOST_LITTLE
+   if (LITTLE == BYTECODEC_HOST_LITTLE) {
+      // host order: the wanted bytes are at the low end of the number
+      #if BYTECODEC_HOST_LITTLE == 0
+         value <<= 8 * (8 - WIDTH);
+      #endif
+      memcpy(output, &value, WIDTH);
+   } else {
+      // other order: swap, then the wanted bytes are at the start
+      #if BYTECODEC_HOST_LITTLE
+         value = __builtin_bswap64(value << (8 * (8 - WIDTH)));
+      #else
+         value = __builtin_bswap64(value);
+      #endif
+      memcpy(output, &value, WIDTH);
+   }
+#else
+   int i;
+   for (i=0; i<WIDTH; i++) {
+      int shift = LITTLE ? i : WIDTH - 1 - i;
+      output[i] = (uchar)(value >> (8 * shift));
+   }
+#endif
+}
+
+
+#define BYTECODEC_WIDTHS(LITTLE, TYPE)                                     \
+   encodeNumber<1, LITTLE, TYPE>, encodeNumber<2, LITTLE, TYPE>,            \
+   encodeNumber<3, LITTLE, TYPE>, encodeNumber<4, LITTLE, TYPE>,            \
+   encodeNumber<5, LITTLE, TYPE>, encodeNumber<6, LITTLE, TYPE>,            \
+   encodeNumber<7, LITTLE, TYPE>, encodeNumber<8, LITTLE, TYPE>
+
+#define BYTECODEC_FLOATS(LITTLE)                                           \
+   NULL, NULL, NULL, encodeNumber<4, LITTLE, NUMBER_FLOAT>,                 \
+   NULL, NULL, NULL, encodeNumber<8, LITTLE, NUMBER_FLOAT>
+
+const NumberEncoder numberEncoders[48] = {
+   BYTECODEC_WIDTHS(0, NUMBER_UNSIGNED), BYTECODEC_WIDTHS(1, NUMBER_UNSIGNED),
+   BYTECODEC_WIDTHS(0, NUMBER_SIGNED),   BYTECODEC_WIDTHS(1, NUMBER_SIGNED),
+   BYTECODEC_FLOATS(0),                  BYTECODEC_FLOATS(1)
+};
+
+
+
+//////////////////////////////
+//
+// spreadGroups -- move the lowest 56 bits of value into the low 7 bits
+//     of each of the eight bytes, least significant group in the lowest
+//     byte.  This is a pdep instruction when BMI2 is available, and
+//     otherwise three rounds of shifting masked halves apart.
+//
+
+static inline ulonglong spreadGroups(ulonglong value) {
+#ifdef __BMI2__
+   return _pdep_u64(value, LOWS);
+#else
+   ulonglong x = value & 0x00ffffffffffffffULL;
+   x = (x & 0x000000000fffffffULL) | ((x & 0x00fffffff0000000ULL) << 4);
+   x = (x & 0x00003fff00003fffULL) | ((x & 0x0fffc0000fffc000ULL) << 2);
+   x = (x & 0x007f007f007f007fULL) | ((x & 0x3f803f803f803f80ULL) << 1);
+   return x;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// gatherGroups -- the reverse of spreadGroups: join the low 7 bits of
+//     each byte into a 56-bit number.
+//
+
+static inline ulonglong gatherGroups(ulonglong bytes) {
+#ifdef __BMI2__
+   return _pext_u64(bytes, LOWS);
+#else
+   ulonglong x = bytes & LOWS;
+   x = (x & 0x007f007f007f007fULL) | ((x & 0x7f007f007f007f00ULL) >> 1);
+   x = (x & 0x00003fff00003fffULL) | ((x & 0x3fff00003fff0000ULL) >> 2);
+   x = (x & 0x000000000fffffffULL) | ((x & 0x0fffffff00000000ULL) >> 4);
+   return x;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// loadLittle -- read up to eight bytes as a little-endian number, with
+//     missing bytes past the end of the input set to zero.
+//
+
+static inline ulonglong loadLittle(const uchar* input, size_t length) {
+   ulonglong word = 0;
+#ifdef BYTECODEC_HOST_LITTLE
+   memcpy(&word, input, length < 8 ? length : 8);
+   #if BYTECODEC_HOST_LITTLE == 0
+      word = __builtin_bswap64(word);
+   #endif
+#else
+   int i;
+   for (i=(int)(length < 8 ? length : 8) - 1; i>=0; i--) {
+      word = (word << 8) | input[i];
+   }
+#endif
+   return word;
+}
+
+
+
+//////////////////////////////
+//
+// storeLittle -- write all eight bytes of a number in little-endian order.
+//
+
+static inline void storeLittle(ulonglong word, uchar* output) {
+#ifdef BYTECODEC_HOST_LITTLE
+   #if BYTECODEC_HOST_LITTLE == 0
+      word = __builtin_bswap64(word);
+   #endif
+   memcpy(output, &word, 8);
+#else
+   int i;
+   for (i=0; i<8; i++) {
+      output[i] = (uchar)(word >> (8 * i));
+   }
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// groupMask -- the bytes which hold the first count groups (1 to 8).
+//
+
+static inline ulonglong groupMask(int count) {
+   return ~0ULL >> (64 - 8 * count);
+}
+
+
+
+//////////////////////////////
+//
+// lebGroups -- store the lowest count 7-bit groups of value in LEB128
+//     order with continuation bits.  Up to eight groups are scattered
+//     and stored as one word; the last two groups of a 64-bit number
+//     are added afterwards, with top holding the bits from bit 63 up.
+//
+
+static inline int lebGroups(ulonglong value, ulonglong top, int count,
+      uchar* output) {
+   ulonglong mask = groupMask(count < 8 ? count : 8);
+   storeLittle((spreadGroups(value) & mask) | (HIGHS & (mask >> 8)), output);
+   if (count > 8) {
+      output[7] |= 0x80;
+      output[8]  = (uchar)(((value >> 56) & 0x7f) | (count > 9 ? 0x80 : 0));
+      output[9]  = (uchar)(top & 0x7f);
+   }
+   return count;
+}
+
+
+
+//////////////////////////////
+//
+// getGroupCount -- number of 7-bit groups needed for a number of bits.
+//
+
+static inline int getGroupCount(int bits) {
+   return (bits + 6) / 7;
+}
+
+
+
+//////////////////////////////
+//
+// encodeUleb128 -- unsigned LEB128: the group count comes from a
+//     leading-zero count, then the groups are scattered in one step.
+//
+
+int encodeUleb128(ulonglong value, uchar* output) {
+   int count = getGroupCount(64 - __builtin_clzll(value | 1));
+   return lebGroups(value, value >> 63, count, output);
+}
+
+
+
+//////////////////////////////
+//
+// encodeSleb128 -- signed LEB128: like encodeUleb128, but the groups
+//     must also hold the sign bit, so the count comes from the number
+//     of redundant sign bits.
+//
+
+int encodeSleb128(longlong value, uchar* output) {
+   int count = getGroupCount(64 - __builtin_clrsbll(value));
+   return lebGroups((ulonglong)value, (ulonglong)(value >> 63), count,
+         output);
+}
+
+
+
+//////////////////////////////
+//
+// encodeVlv -- MIDI variable-length value: the groups are scattered as
+//     for LEB128, continuation bits are set on all but the least
+//     significant group, and then a byte swap puts the most significant
+//     group first.
+//
+
+int encodeVlv(ulonglong value, uchar* output) {
+   int count = getGroupCount(64 - __builtin_clzll(value | 1));
+   if (count <= 8) {
+      ulonglong mask = groupMask(count);
+      ulonglong word = (spreadGroups(value) & mask) | (HIGHS & mask & ~0xffULL);
+      storeLittle(__builtin_bswap64(word) >> (64 - 8 * count), output);
+   } else {
+      output[0] = (uchar)(0x80 | (value >> (count > 9 ? 63 : 56)));
+      output[1] = (uchar)(0x80 | ((value >> 56) & 0x7f));
+      ulonglong word = spreadGroups(value) | (HIGHS & ~0xffULL);
+      storeLittle(__builtin_bswap64(word), output + count - 8);
+   }
+   return count;
+}
+
+
+
+//////////////////////////////
+//
+// findGroups -- find the last byte of a variable-length number from the
+//     first byte without a continuation bit among up to eight bytes.
+//     Returns the number of bytes (1 to 8), or 0 if there is no end in
+//     the first eight bytes.
+//
+
+static inline int findGroups(ulonglong word, size_t length) {
+   ulonglong ends = ~word & HIGHS & groupMask(length < 8 ? (int)length : 8);
+   return ends ? __builtin_ctzll(ends) / 8 + 1 : 0;
+}
+
+
+
+//////////////////////////////
+//
+// decodeLongGroups -- check the ninth and tenth bytes of a 64-bit
+//     variable-length number, and read them as the top LEB128 groups.
+//     Returns the number of bytes, or 0 if the number does not end by
+//     the tenth byte.
+//
+
+static int decodeLongGroups(const uchar* input, size_t length,
+      ulonglong& high) {
+   if (length < 9) {
+      return 0;
+   }
+   high = (ulonglong)(input[8] & 0x7f);
+   if (input[8] < 0x80) {
+      return 9;
+   }
+   if (length < 10 || input[9] >= 0x80) {
+      return 0;
+   }
+   high |= (ulonglong)input[9] << 7;
+   return 10;
+}
+
+
+
+//////////////////////////////
+//
+// decodeUleb128 -- read an unsigned LEB128 number.  The end is found
+//     with a trailing-zero count over the continuation bits of eight
+//     bytes, and the groups are then gathered in one step.
+//
+
+int decodeUleb128(const uchar* input, size_t length, ulonglong& value) {
+   if (length == 0) {
+      return 0;
+   }
+   ulonglong word = loadLittle(input, length);
+   int count = findGroups(word, length);
+   if (count) {
+      value = gatherGroups(word & groupMask(count));
+      return count;
+   }
+   if (length < 8) {
+      return 0;
+   }
+   ulonglong high = 0;
+   count = decodeLongGroups(input, length, high);
+   if (count == 0) {
+      return 0;
+   }
+   value = gatherGroups(word) | (high << 56);
+   return count;
+}
+
+
+
+//////////////////////////////
+//
+// decodeSleb128 -- read a signed LEB128 number: an unsigned read followed
+//     by sign extension from the top bit of the last group.
+//
+
+int decodeSleb128(const uchar* input, size_t length, longlong& value) {
+   ulonglong raw = 0;
+   int count = decodeUleb128(input, length, raw);
+   int shift = 64 - 7 * count;
+   if (count > 0 && shift > 0) {
+      value = (longlong)(raw << shift) >> shift;
+   } else {
+      value = (longlong)raw;
+   }
+   return count;
+}
+
+
+
+//////////////////////////////
+//
+// decodeVlv -- read a MIDI variable-length value.  The end is found as
+//     in decodeUleb128, and a byte swap puts the least significant
+//     group into the lowest byte before the groups are gathered.
+//
+
+int decodeVlv(const uchar* input, size_t length, ulonglong& value) {
+   if (length == 0) {
+      return 0;
+   }
+   ulonglong word = loadLittle(input, length);
+   int count = findGroups(word, length);
+   if (count) {
+      word = __builtin_bswap64(word & groupMask(count)) >> (64 - 8 * count);
+      value = gatherGroups(word);
+      return count;
+   }
+   if (length < 8) {
+      return 0;
+   }
+   // over 56 bits: one or two more groups come before the last eight
+   ulonglong high = 0;
+   count = decodeLongGroups(input, length, high);
+   if (count == 0) {
+      return 0;
+   }
+   high = input[0] & 0x7f;
+   if (count > 9) {
+      high = (high << 7) | (input[1] & 0x7f);
+   }
+   word  = loadLittle(input + count - 8, 8);
+   value = gatherGroups(__builtin_bswap64(word)) | (high << 56);
+   return count;
+}
+
+
+
@@ -0,0 +1,73 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 14:25:51 PDT 2026
+// Last Modified: Sun Oct 18 16:03:19 PDT 2026 Added number encoders
+// Last Modified: Sun Oct 18 16:48:52 PDT 2026 Added VLV and LEB128 numbers
+// Filename:      ...binasc/ByteCodec.h
+// Syntax:        C++
+//
+// Description:   Functions for converting between bytes and their text
+//                encodings in bulk.  Hexadecimal text is decoded eight
+//                characters at a time inside of 64-bit words.  Numbers
+//                are stored by encoders which are generated for every
+//                byte count and byte order at compile time.
+//                Variable-length numbers are converted a word at a time
+//                by scattering or gathering their 7-bit groups.
+//
+
+#ifndef _BYTECODEC_H_INCLUDED
+#define _BYTECODEC_H_INCLUDED
+
+#include <stddef.h>
+
+typedef unsigned char      uchar;
+typedef unsigned long long ulonglong;
+typedef long long          longlong;
+
+// Number types for getNumberDescriptor():
+#define NUMBER_UNSIGNED 0
+#define NUMBER_SIGNED   1
+#define NUMBER_FLOAT    2
+
+// A NumberEncoder stores the lowest bytes of an integer (or a float or
+// double given as the bits of a double) at output in a fixed byte order.
+typedef void (*NumberEncoder)(ulonglong value, uchar* output);
+
+// numberEncoders -- indexed by getNumberDescriptor(); NULL for byte
+//     counts which a type cannot use (floats are 4 or 8 bytes).
+extern const NumberEncoder numberEncoders[48];
+
+inline int getNumberDescriptor(int byteCount, int littleQ, int type) {
+   return (type * 2 + (littleQ ? 1 : 0)) * 8 + byteCount - 1;
+}
+
+
+// decodeHex -- decode an even number of hexadecimal digits.
+int      decodeHex             (const char* text, size_t length,
+                                uchar* output);
+
+// decodeBase64 -- decode base64 text with optional '=' padding.
+int      decodeBase64          (const char* text, size_t length,
+                                uchar* output);
+size_t   getBase64DecodedSize  (const char* text, size_t length);
+
+// Variable-length numbers in 7-bit groups: MIDI VLVs store the most
+// significant group first, and LEB128 numbers store the least
+// significant group first.  Encoders need room for 10 bytes of output
+// and return the number of bytes used.  Decoders return the number of
+// bytes read, or 0 if the number is cut off or longer than 10 bytes.
+int      encodeVlv             (ulonglong value, uchar* output);
+int      encodeUleb128         (ulonglong value, uchar* output);
+int      encodeSleb128         (longlong value, uchar* output);
+int      decodeVlv             (const uchar* input, size_t length,
+                                ulonglong& value);
+int      decodeUleb128         (const uchar* input, size_t length,
+                                ulonglong& value);
+int      decodeSleb128         (const uchar* input, size_t length,
+                                longlong& value);
+
+
+#endif  /* _BYTECODEC_H_INCLUDED */
+
+
+
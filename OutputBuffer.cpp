@@ -0,0 +1,1052 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 10:14:22 PDT 2026
+// Last Modified: Sun Oct 18 11:02:40 PDT 2026 Added copyFrom()
+// Last Modified: Sun Oct 18 12:31:05 PDT 2026 Added hold() and patch()
+// Last Modified: Sun Oct 18 16:03:19 PDT 2026 Numbers moved to ByteCodec
+// Last Modified: Sun Oct 18 17:26:40 PDT 2026 Added discard()
+// Last Modified: Sun Oct 18 18:05:12 PDT 2026 Added sinks and good()
+// Last Modified: Sun Oct 18 22:41:10 PDT 2026 Zero blocks become holes
+// Last Modified: Sun Oct 18 23:08:52 PDT 2026 Added writeBehind()
+// Last Modified: Mon Oct 19 00:31:20 PDT 2026 Memory from the caller
+// Last Modified: Mon Oct 19 05:34:02 PDT 2026 repeat() checks the size
+// Filename:      ...binasc/OutputBuffer.cpp
+// Syntax:        C++
+//
+// Description:   Block-buffered binary output for compiled bytes.  The
+//                output goes either to a file descriptor or, when no file
+//                has been opened, into a growing memory buffer.  Runs of
+//                identical bytes are written in bulk, and runs of zeros
+//                become holes when the output is a regular file.
+//                Bytes which will be filled in later can be held back
+//                from a pipe and then patched in place.  Output can
+//                also be discarded, keeping only the count of bytes, or
+//                passed to a sink function.  Errors are kept rather than
+//                stopping the program, and later output is discarded.
+//                Files can be allocated ahead of time, and written by a
+//                background thread while the next block is filled.
+//
+
+#include "OutputBuffer.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef LINUX
+   #include <sys/sendfile.h>
+#endif
+
+#ifndef O_BINARY
+   #define O_BINARY 0
+#endif
+
+using namespace std;
+
+
+//////////////////////////////
+//
+// OutputBuffer::OutputBuffer --
+//
+
+OutputBuffer::OutputBuffer(void) {
+   fd       = -1;
+   seekable = 0;
+   holeQ    = 0;
+   discardQ = 0;
+   sink     = NULL;
+   sinkData = NULL;
+   buffer   = NULL;
+   borrowedQ = 0;
+   used     = 0;
+   capacity = 0;
+   flushed  = 0;
+   allocated     = 0;
+   writer        = NULL;
+   pending       = NULL;
+   pendingCount  = 0;
+   pendingOffset = 0;
+   writerStopQ   = 0;
+   spare         = NULL;
+   spareCapacity = 0;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::~OutputBuffer --
+//
+
+OutputBuffer::~OutputBuffer() {
+   close();
+   if (buffer != NULL && !borrowedQ) {
+      delete [] buffer;
+   }
+   buffer = NULL;
+   if (spare != NULL) {
+      delete [] spare;
+      spare = NULL;
+   }
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::open -- open a file for writing.  Returns 0 if the file
+//     could not be opened.
+//
+
+int OutputBuffer::open(const char* filename) {
+   close();
+   fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+   if (fd < 0) {
+      return 0;
+   }
+   struct stat info;
+   seekable = (fstat(fd, &info) == 0) && S_ISREG(info.st_mode);
+   holeQ    = 0;
+   allocated = 0;
+   discardQ = 0;
+   used     = 0;
+   flushed  = 0;
+   errorMessage.clear();
+   makeBuffer();
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::open -- send the output to a function rather than a file.
+//     The function is called with blocks of bytes, and is treated like a
+//     pipe: bytes are only passed to it once they will not be patched.
+//
+
+int OutputBuffer::open(OutputSink function, void* userData) {
+   close();
+   if (function == NULL) {
+      return 0;
+   }
+   sink     = function;
+   sinkData = userData;
+   seekable = 0;
+   holeQ    = 0;
+   discardQ = 0;
+   used     = 0;
+   flushed  = 0;
+   errorMessage.clear();
+   makeBuffer();
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::open -- collect the output in memory, starting in size
+//     bytes supplied by the caller, which must stay valid while they are
+//     in use.  If the output grows larger it moves to the heap as usual.
+//     Returns 0 if no memory is given.
+//
+
+int OutputBuffer::open(uchar* memory, size_t size) {
+   close();
+   if (memory == NULL || size == 0) {
+      return 0;
+   }
+   if (buffer != NULL && !borrowedQ) {
+      delete [] buffer;
+   }
+   buffer    = memory;
+   capacity  = size;
+   borrowedQ = 1;
+   seekable  = 0;
+   holeQ     = 0;
+   discardQ  = 0;
+   used      = 0;
+   flushed   = 0;
+   errorMessage.clear();
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::discard -- throw away everything written from now on,
+//     so that only tell() and the checks on patch() remain.  Used to
+//     check input quickly without creating any output.
+//
+
+void OutputBuffer::discard(void) {
+   close();
+   discardQ = 1;
+   seekable = 0;
+   holeQ    = 0;
+   used     = 0;
+   flushed  = 0;
+   makeBuffer();
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::preallocate -- reserve disk space for a file of the given
+//     size, so that the file system can place it in one piece and later
+//     writes do not wait for blocks to be allocated.  The size may be a
+//     guess: close() cuts the file back to the bytes actually written.
+//     Only an empty file can be preallocated.  Returns 0 if the space
+//     was not allocated, which is not an error.
+//
+
+int OutputBuffer::preallocate(ulonglong size) {
+   if (fd < 0 || !seekable || discardQ || writer != NULL ||
+         flushed + used > 0 || size == 0) {
+      return 0;
+   }
+#ifdef LINUX
+   if (fallocate(fd, 0, 0, (off_t)size) == 0) {
+      if (size > allocated) {
+         allocated = size;
+      }
+      return 1;
+   }
+#endif
+   return 0;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::writeBehind -- write the file on a background thread.
+//     Each full buffer is handed to the thread and the program carries
+//     on filling a second buffer, so that it only waits for the disk
+//     when the disk is slower than the compiler.  Bytes which are
+//     patched, copied or skipped over are first allowed to reach the
+//     file.  The thread is stopped by close().  Returns 0 if the output
+//     is not a file.
+//
+
+int OutputBuffer::writeBehind(void) {
+   if (fd < 0 || discardQ) {
+      return 0;
+   }
+   if (writer == NULL) {
+      writerStopQ = 0;
+      writer = new thread(&OutputBuffer::writerLoop, this);
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::close -- write any pending bytes and close the file.
+//     A file ending in a hole is extended to its full length, and a
+//     preallocated file is cut back to its full length.
+//
+
+void OutputBuffer::close(void) {
+   if (!streamQ()) {
+      return;
+   }
+   holds.clear();
+   flush();
+   stopWriter();
+   if (fd >= 0) {
+      if ((holeQ || allocated > flushed) &&
+            ftruncate(fd, (off_t)flushed) != 0) {
+         fail(string("cannot set length of output file: ") +
+               strerror(errno));
+      }
+      ::close(fd);
+      fd = -1;
+   }
+   sink = NULL;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::is_open -- returns true if writing to a file.
+//
+
+int OutputBuffer::is_open(void) const {
+   return streamQ() || discardQ;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::clear -- discard the contents of a memory buffer.
+//
+
+void OutputBuffer::clear(void) {
+   used = 0;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::operator<< -- append a single byte.
+//
+
+OutputBuffer& OutputBuffer::operator<<(uchar aByte) {
+   *reserve(1) = aByte;
+   return *this;
+}
+
+OutputBuffer& OutputBuffer::operator<<(char aByte) {
+   *reserve(1) = (uchar)aByte;
+   return *this;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::write -- append a block of bytes.  Blocks larger than
+//     the buffer go straight to the file.
+//
+
+void OutputBuffer::write(const void* data, size_t count) {
+   const uchar* bytes = (const uchar*)data;
+   if (discardQ && count >= capacity) {
+      flush();
+      flushed += count;
+      return;
+   }
+   if (streamQ() && count >= capacity && !heldQ()) {
+      flush();
+      waitForWriter();
+      if (!discardQ && !writeSparse(bytes, count, flushed)) {
+         fail(writeError);
+      }
+      flushed += count;
+      return;
+   }
+   memcpy(reserve(count), bytes, count);
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::fill -- append count copies of a byte.  Long runs of
+//     zeros written to a regular file are skipped over with lseek and
+//     left as a hole in the file.
+//
+
+void OutputBuffer::fill(uchar aByte, ulonglong count) {
+   if (discardQ) {
+      flush();
+      flushed += count;
+      return;
+   }
+   if (aByte == 0 && seekable && fd >= 0 && count >= OUTPUTBUFFER_BLOCK) {
+      flush();
+      waitForWriter();
+      if (!discardQ && skipZeros(flushed, count)) {
+         flushed += count;
+         return;
+      }
+   }
+
+   while (count > 0) {
+      size_t chunk = OUTPUTBUFFER_BLOCK;
+      if (chunk > count) {
+         chunk = (size_t)count;
+      }
+      memset(reserve(chunk), aByte, chunk);
+      count -= chunk;
+   }
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::repeat -- append count copies of a sequence of bytes.
+//     The sequence is expanded by doubling, straight into the buffer when
+//     the copies fit in a block, or else into a block which is then
+//     written repeatedly.  Returns 0, and writes nothing, if the total
+//     size is too large for a 64-bit count.
+//
+
+int OutputBuffer::repeat(const void* data, size_t size, ulonglong count) {
+   const uchar* bytes = (const uchar*)data;
+   if (size == 0 || count == 0) {
+      return 1;
+   }
+   if (count > ~0ULL / size) {
+      return 0;
+   }
+   if (discardQ) {
+      fill(0, (ulonglong)size * count);
+      return 1;
+   }
+   size_t i;
+   for (i=0; i<size; i++) {
+      if (bytes[i] != bytes[0]) {
+         break;
+      }
+   }
+   if (i == size) {
+      fill(bytes[0], (ulonglong)size * count);
+      return 1;
+   }
+
+   if ((ulonglong)size * count <= OUTPUTBUFFER_BLOCK) {
+      // short runs are expanded in place by doubling
+      size_t total  = (size_t)(size * count);
+      uchar* output = reserve(total);
+      memcpy(output, bytes, size);
+      size_t filled = size;
+      while (filled < total) {
+         size_t chunk = filled;
+         if (filled + chunk > total) {
+            chunk = total - filled;
+         }
+         memcpy(output + filled, output, chunk);
+         filled += chunk;
+      }
+      return 1;
+   }
+
+   ulonglong perBlock = OUTPUTBUFFER_BLOCK / size;
+   if (perBlock == 0) {
+      perBlock = 1;
+   }
+   if (perBlock > count) {
+      perBlock = count;
+   }
+   size_t blockSize = (size_t)(perBlock * size);
+   uchar* block = new uchar[blockSize];
+   memcpy(block, bytes, size);
+   size_t filled = size;
+   while (filled < blockSize) {
+      size_t chunk = filled;
+      if (filled + chunk > blockSize) {
+         chunk = blockSize - filled;
+      }
+      memcpy(block + filled, block, chunk);
+      filled += chunk;
+   }
+
+   while (count >= perBlock) {
+      write(block, blockSize);
+      count -= perBlock;
+   }
+   if (count > 0) {
+      write(block, (size_t)(count * size));
+   }
+   delete [] block;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::copyFrom -- append count bytes read from another file
+//     starting at the given offset.  When writing to a file on Linux the
+//     bytes are moved by the kernel with copy_file_range (or sendfile
+//     if the two files cannot share a copy), otherwise they are read
+//     into the buffer.  Returns 0 if the input file is too short or
+//     cannot be read.
+//
+
+int OutputBuffer::copyFrom(int infd, ulonglong offset, ulonglong count) {
+   if (discardQ) {
+      fill(0, count);
+      return 1;
+   }
+   if (streamQ()) {
+      flush();
+      waitForWriter();
+      holeQ = 0;
+   }
+   if (discardQ) {
+      fill(0, count);
+      return 1;
+   }
+
+#ifdef LINUX
+   if (fd >= 0 && !heldQ()) {
+      off_t position = (off_t)offset;
+      int sendfileQ = 0;
+      while (count > 0) {
+         size_t chunk = count > 0x40000000ULL ? 0x40000000 : (size_t)count;
+         ssize_t status;
+         if (sendfileQ) {
+            status = sendfile(fd, infd, &position, chunk);
+         } else {
+            status = copy_file_range(infd, &position, fd, NULL, chunk, 0);
+         }
+         if (status < 0 && errno == EINTR) {
+            continue;
+         }
+         if (status < 0 && !sendfileQ && (errno == EXDEV || errno == EINVAL
+               || errno == ENOSYS || errno == EOPNOTSUPP)) {
+            sendfileQ = 1;
+            continue;
+         }
+         if (status < 0 && position == (off_t)offset) {
+            // neither system call works for these files
+            break;
+         }
+         if (status <= 0) {
+            return 0;
+         }
+         count   -= status;
+         flushed += status;
+      }
+      if (count == 0) {
+         return 1;
+      }
+      offset = (ulonglong)position;
+   }
+#endif
+
+   while (count > 0) {
+      size_t chunk = OUTPUTBUFFER_BLOCK;
+      if (chunk > count) {
+         chunk = (size_t)count;
+      }
+      uchar* output = reserve(chunk);
+      ssize_t status = pread(infd, output, chunk, (off_t)offset);
+      if (status < 0 && errno == EINTR) {
+         used -= chunk;
+         continue;
+      }
+      if (status <= 0) {
+         used -= chunk;
+         return 0;
+      }
+      used   -= chunk - status;
+      offset += status;
+      count  -= status;
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::hold -- keep the bytes from offset onwards in memory until
+//     the hold is released, so that they can still be patched when the
+//     output is a pipe.  Regular files are patched on disk instead, so
+//     holds do not affect them.
+//
+
+void OutputBuffer::hold(ulonglong offset) {
+   holds.insert(offset);
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::release -- remove a hold placed at offset.
+//
+
+void OutputBuffer::release(ulonglong offset) {
+   std::multiset<ulonglong>::iterator it = holds.find(offset);
+   if (it != holds.end()) {
+      holds.erase(it);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::patch -- overwrite bytes which were written earlier.
+//
+
+void OutputBuffer::patch(ulonglong offset, const void* data, size_t count) {
+   const uchar* bytes = (const uchar*)data;
+   if (offset + count > tell()) {
+      fail("cannot patch bytes past the end of the output");
+      return;
+   }
+   if (offset < flushed) {
+      waitForWriter();
+   }
+   if (discardQ) {
+      return;
+   }
+   while (count > 0 && offset < flushed) {
+      if (fd < 0 || !seekable) {
+         fail("output bytes were already written");
+         return;
+      }
+      size_t chunk = count;
+      if (offset + chunk > flushed) {
+         chunk = (size_t)(flushed - offset);
+      }
+      ssize_t status = pwrite(fd, bytes, chunk, (off_t)offset);
+      if (status < 0 && errno == EINTR) {
+         continue;
+      }
+      if (status <= 0) {
+         fail(string("cannot write output file: ") + strerror(errno));
+         return;
+      }
+      bytes  += status;
+      offset += status;
+      count  -= status;
+   }
+   if (count > 0) {
+      memcpy(buffer + (offset - flushed), bytes, count);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::reserve -- returns space for count more bytes at the end
+//     of the buffer, so that they can be stored there directly.  The
+//     space is counted as written.
+//
+
+uchar* OutputBuffer::reserve(size_t count) {
+   if (used + count > capacity && (streamQ() || discardQ)) {
+      flush();
+      if (used + count > OUTPUTBUFFER_WINDOW) {
+         fail("more than 64 megabytes are waiting for a forward "
+              "reference, which needs a regular output file rather "
+              "than a pipe");
+         flush();
+      }
+   }
+   if (used + count > capacity) {
+      size_t newsize = capacity < 256 ? 256 : capacity * 2;
+      while (newsize < used + count) {
+         newsize *= 2;
+      }
+      uchar* newbuffer = new uchar[newsize];
+      if (used > 0) {
+         memcpy(newbuffer, buffer, used);
+      }
+      if (buffer != NULL && !borrowedQ) {
+         delete [] buffer;
+      }
+      buffer    = newbuffer;
+      capacity  = newsize;
+      borrowedQ = 0;
+   }
+   uchar* output = buffer + used;
+   used += count;
+   return output;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::tell -- returns the number of bytes written so far.
+//
+
+ulonglong OutputBuffer::tell(void) const {
+   return flushed + used;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::getData -- returns the contents of a memory buffer.
+//
+
+const uchar* OutputBuffer::getData(void) const {
+   return buffer;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::getSize -- returns the number of bytes in the buffer.
+//
+
+size_t OutputBuffer::getSize(void) const {
+   return used;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::good -- returns true if there have been no errors.
+//
+
+int OutputBuffer::good(void) const {
+   return errorMessage.empty();
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::getError -- returns a description of the first error,
+//     or an empty string.
+//
+
+const char* OutputBuffer::getError(void) const {
+   return errorMessage.c_str();
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+
+//////////////////////////////
+//
+// OutputBuffer::flush -- pass the pending bytes to the file.
+//
+
+void OutputBuffer::flush(void) {
+   if (discardQ) {
+      flushed += used;
+      used = 0;
+      return;
+   }
+   if (!streamQ() || used == 0) {
+      return;
+   }
+   size_t count = used;
+   if (heldQ()) {
+      ulonglong limit = *holds.begin();
+      count = limit > flushed ? (size_t)(limit - flushed) : 0;
+      if (count > used) {
+         count = used;
+      }
+   }
+   if (count == 0) {
+      return;
+   }
+   if (writer != NULL) {
+      // hand the bytes to the writer thread and carry on in the spare
+      waitForWriter();
+      if (discardQ) {
+         flush();
+         return;
+      }
+      if (spareCapacity < capacity) {
+         if (spare != NULL) {
+            delete [] spare;
+         }
+         spare         = new uchar[capacity];
+         spareCapacity = capacity;
+      }
+      if (count < used) {
+         memcpy(spare, buffer + count, used - count);
+      }
+      {
+         lock_guard<mutex> guard(writerLock);
+         pending       = buffer;
+         pendingCount  = count;
+         pendingOffset = flushed;
+      }
+      writerSignal.notify_all();
+      uchar* full   = buffer;
+      buffer        = spare;
+      spare         = full;
+      size_t size   = capacity;
+      capacity      = spareCapacity;
+      spareCapacity = size;
+   } else {
+      if (!writeSparse(buffer, count, flushed)) {
+         fail(writeError);
+         flush();   // now discarding
+         return;
+      }
+      if (count < used) {
+         memmove(buffer, buffer + count, used - count);
+      }
+   }
+   flushed += count;
+   used    -= count;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::makeBuffer -- make sure that the buffer belongs to the
+//     object and can hold a block of output.
+//
+
+void OutputBuffer::makeBuffer(void) {
+   if (capacity >= OUTPUTBUFFER_BLOCK && !borrowedQ) {
+      return;
+   }
+   if (buffer != NULL && !borrowedQ) {
+      delete [] buffer;
+   }
+   capacity  = OUTPUTBUFFER_BLOCK;
+   buffer    = new uchar[capacity];
+   borrowedQ = 0;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::heldQ -- returns true if some of the buffered bytes have
+//     to stay in memory until they are patched.
+//
+
+int OutputBuffer::heldQ(void) const {
+   return streamQ() && !seekable && !holds.empty();
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::streamQ -- returns true if bytes are passed on to a file
+//     or sink function rather than kept in memory.
+//
+
+int OutputBuffer::streamQ(void) const {
+   return fd >= 0 || sink != NULL;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::writeOut -- pass bytes to the file or sink function.
+//     Returns 0 after an error, leaving the reason in writeError.  This
+//     may run on the writer thread, so it does not call fail().
+//
+
+int OutputBuffer::writeOut(const uchar* data, size_t count) {
+   if (sink != NULL) {
+      if (!sink(data, count, sinkData)) {
+         writeError = "output sink could not accept the bytes";
+         return 0;
+      }
+      return 1;
+   }
+   while (count > 0) {
+      ssize_t status = ::write(fd, data, count);
+      if (status < 0) {
+         if (errno == EINTR) {
+            continue;
+         }
+         writeError = string("cannot write output file: ") + strerror(errno);
+         return 0;
+      }
+      data  += status;
+      count -= status;
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::writeSparse -- pass bytes to the file, where they start
+//     at the given offset.  When the file is a regular file, blocks of
+//     OUTPUTBUFFER_HOLE zeros on block boundaries of the file are skipped
+//     over with lseek, and close() sets the final length if the file
+//     ends in a hole.  Other outputs are passed to writeOut().  Returns
+//     0 after an error, like writeOut().
+//
+
+int OutputBuffer::writeSparse(const uchar* data, size_t count,
+      ulonglong offset) {
+   if (!seekable || fd < 0) {
+      return writeOut(data, count);
+   }
+   size_t start = 0;    // first byte not yet written
+   size_t index = (size_t)((OUTPUTBUFFER_HOLE - offset % OUTPUTBUFFER_HOLE)
+         % OUTPUTBUFFER_HOLE);
+   while (index + OUTPUTBUFFER_HOLE <= count) {
+      if (!zeroBlockQ(data + index)) {
+         index += OUTPUTBUFFER_HOLE;
+         continue;
+      }
+      size_t ending = index + OUTPUTBUFFER_HOLE;
+      while (ending + OUTPUTBUFFER_HOLE <= count &&
+            zeroBlockQ(data + ending)) {
+         ending += OUTPUTBUFFER_HOLE;
+      }
+      if (!writeOut(data + start, index - start)) {
+         return 0;
+      }
+      if (!skipZeros(offset + index, ending - index)) {
+         writeError = string("cannot seek in output file: ") +
+               strerror(errno);
+         return 0;
+      }
+      start = index = ending;
+   }
+   if (start < count) {
+      if (!writeOut(data + start, count - start)) {
+         return 0;
+      }
+      holeQ = 0;
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::skipZeros -- move the file position over count zeros at
+//     the given offset without writing them.  Space allocated there by
+//     preallocate() is given back, so that the zeros stay a hole.
+//     Returns 0 if the file position cannot be moved.
+//
+
+int OutputBuffer::skipZeros(ulonglong offset, ulonglong count) {
+   if (lseek(fd, (off_t)count, SEEK_CUR) == (off_t)-1) {
+      return 0;
+   }
+#ifdef LINUX
+   if (offset < allocated) {
+      ulonglong ending = offset + count;
+      if (ending > allocated) {
+         ending = allocated;
+      }
+      // failing to free the space is harmless: it still reads as zeros
+      fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+            (off_t)offset, (off_t)(ending - offset));
+   }
+#endif
+   holeQ = 1;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::zeroBlockQ -- returns true if the OUTPUTBUFFER_HOLE bytes
+//     at data are all zero.  Comparing the block with itself shifted by
+//     one byte lets memcmp() do the work a word at a time.
+//
+
+int OutputBuffer::zeroBlockQ(const uchar* data) {
+   return data[0] == 0 && memcmp(data, data + 1, OUTPUTBUFFER_HOLE - 1) == 0;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::writerLoop -- the writer thread: write each block handed
+//     over by flush() until stopWriter() is called.
+//
+
+void OutputBuffer::writerLoop(void) {
+   unique_lock<mutex> guard(writerLock);
+   while (1) {
+      while (pending == NULL && !writerStopQ) {
+         writerSignal.wait(guard);
+      }
+      if (pending == NULL) {
+         return;
+      }
+      guard.unlock();
+      // the other thread does not touch the pending bytes until they
+      // are written, so they are read without the lock
+      int status = writeSparse(pending, pendingCount, pendingOffset);
+      guard.lock();
+      if (!status) {
+         writerStopQ = 1;
+      }
+      pending = NULL;
+      writerSignal.notify_all();
+   }
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::waitForWriter -- wait until the writer thread has
+//     written the block it was given, so that the file can be used
+//     directly.  An error in the writer is kept as the output error.
+//
+
+void OutputBuffer::waitForWriter(void) {
+   if (writer == NULL) {
+      return;
+   }
+   unique_lock<mutex> guard(writerLock);
+   while (pending != NULL) {
+      writerSignal.wait(guard);
+   }
+   if (writerStopQ && !writeError.empty()) {
+      string message = writeError;
+      writeError.clear();
+      guard.unlock();
+      fail(message);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::stopWriter -- wait for the writer thread to finish its
+//     last block, and end the thread.
+//
+
+void OutputBuffer::stopWriter(void) {
+   if (writer == NULL) {
+      return;
+   }
+   waitForWriter();
+   {
+      lock_guard<mutex> guard(writerLock);
+      writerStopQ = 1;
+   }
+   writerSignal.notify_all();
+   writer->join();
+   delete writer;
+   writer      = NULL;
+   writerStopQ = 0;
+}
+
+
+
+//////////////////////////////
+//
+// OutputBuffer::fail -- keep the first error, and discard all further
+//     output.
+//
+
+void OutputBuffer::fail(const string& message) {
+   if (errorMessage.empty()) {
+      errorMessage = message;
+   }
+   discardQ = 1;
+   holds.clear();
+}
+
+
+
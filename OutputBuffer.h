@@ -0,0 +1,143 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 10:14:22 PDT 2026
+// Last Modified: Sun Oct 18 11:02:40 PDT 2026 Added copyFrom()
+// Last Modified: Sun Oct 18 12:31:05 PDT 2026 Added hold() and patch()
+// Last Modified: Sun Oct 18 16:03:19 PDT 2026 Numbers moved to ByteCodec
+// Last Modified: Sun Oct 18 17:26:40 PDT 2026 Added discard()
+// Last Modified: Sun Oct 18 18:05:12 PDT 2026 Added sinks and good()
+// Last Modified: Sun Oct 18 22:41:10 PDT 2026 Zero blocks become holes
+// Last Modified: Sun Oct 18 23:08:52 PDT 2026 Added writeBehind()
+// Last Modified: Mon Oct 19 00:31:20 PDT 2026 Memory from the caller
+// Last Modified: Mon Oct 19 05:34:02 PDT 2026 repeat() checks the size
+// Filename:      ...binasc/OutputBuffer.h
+// Syntax:        C++
+//
+// Description:   Block-buffered binary output for compiled bytes.  The
+//                output goes either to a file descriptor or, when no file
+//                has been opened, into a growing memory buffer.  Runs of
+//                identical bytes are written in bulk, and runs of zeros
+//                become holes when the output is a regular file.
+//                Bytes which will be filled in later can be held back
+//                from a pipe and then patched in place.  Output can
+//                also be discarded, keeping only the count of bytes, or
+//                passed to a sink function.  Errors are kept rather than
+//                stopping the program, and later output is discarded.
+//                Files can be allocated ahead of time, and written by a
+//                background thread while the next block is filled.
+//
+
+#ifndef _OUTPUTBUFFER_H_INCLUDED
+#define _OUTPUTBUFFER_H_INCLUDED
+
+#include <stddef.h>
+#include <set>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+typedef unsigned char      uchar;
+typedef unsigned short     ushort;
+typedef unsigned int       uint;
+typedef unsigned long long ulonglong;
+
+#define OUTPUTBUFFER_BLOCK  (64 * 1024)
+#define OUTPUTBUFFER_WINDOW (64 * 1024 * 1024)
+
+// Blocks of zeros this large, on block boundaries of a regular output
+// file, are left as holes rather than written.
+#define OUTPUTBUFFER_HOLE   (4 * 1024)
+
+// An OutputSink receives each block of output bytes, and returns 0 if
+// the bytes could not be written.
+typedef int (*OutputSink)(const uchar* data, size_t count, void* userData);
+
+
+class OutputBuffer {
+   public:
+                     OutputBuffer          (void);
+                    ~OutputBuffer          ();
+
+      int            open                  (const char* filename);
+      int            open                  (OutputSink function, 
+                                            void* userData);
+      int            open                  (uchar* memory, size_t size);
+      void           discard               (void);
+      int            preallocate           (ulonglong size);
+      int            writeBehind           (void);
+      void           close                 (void);
+      int            is_open               (void) const;
+      void           clear                 (void);
+
+      OutputBuffer&  operator<<            (uchar aByte);
+      OutputBuffer&  operator<<            (char aByte);
+      void           write                 (const void* data, size_t count);
+      void           fill                  (uchar aByte, ulonglong count);
+      int            repeat                (const void* data, size_t size,
+                                            ulonglong count);
+      int            copyFrom              (int infd, ulonglong offset,
+                                            ulonglong count);
+      void           hold                  (ulonglong offset);
+      void           release               (ulonglong offset);
+      void           patch                 (ulonglong offset, const void* data,
+                                            size_t count);
+
+      uchar*         reserve               (size_t count);
+
+      ulonglong      tell                  (void) const;
+      const uchar*   getData               (void) const;
+      size_t         getSize               (void) const;
+      int            good                  (void) const;
+      const char*    getError              (void) const;
+
+   protected:
+      int            fd;           // output file (-1 = memory output)
+      int            seekable;     // output is a regular file
+      int            holeQ;        // a hole is pending at the end of file
+      int            discardQ;     // only count the bytes written
+      OutputSink     sink;         // function receiving output, or NULL
+      void*          sinkData;     // user data for the sink function
+      std::string    errorMessage; // first error, or empty
+      uchar*         buffer;       // pending bytes (or all bytes in memory)
+      int            borrowedQ;    // buffer belongs to the caller
+      size_t         used;         // number of bytes in buffer
+      size_t         capacity;     // allocated size of buffer
+      ulonglong      flushed;      // bytes already passed to the file
+      std::multiset<ulonglong> holds; // offsets not yet ready for a pipe
+      ulonglong      allocated;    // file size set by preallocate()
+
+      // write-behind thread (see writeBehind())
+      std::thread*   writer;       // background writer, or NULL
+      std::mutex     writerLock;   // guards pending and writerStopQ
+      std::condition_variable writerSignal; // pending or writerStopQ changed
+      uchar*         pending;      // bytes being written, or NULL
+      size_t         pendingCount; // number of pending bytes
+      ulonglong      pendingOffset; // file offset of the pending bytes
+      int            writerStopQ;  // the writer should finish
+      uchar*         spare;        // second buffer, filled while writing
+      size_t         spareCapacity; // allocated size of spare
+      std::string    writeError;   // reason the last write failed
+
+      void           flush                 (void);
+      void           makeBuffer            (void);
+      int            heldQ                 (void) const;
+      int            streamQ               (void) const;
+      int            writeOut              (const uchar* data, size_t count);
+      int            writeSparse           (const uchar* data, size_t count,
+                                            ulonglong offset);
+      void           writerLoop            (void);
+      void           waitForWriter         (void);
+      void           stopWriter            (void);
+      int            skipZeros             (ulonglong offset,
+                                            ulonglong count);
+      static int     zeroBlockQ            (const uchar* data);
+      void           fail                  (const std::string& message);
+};
+
+
+
+#endif  /* _OUTPUTBUFFER_H_INCLUDED */
+
+
+
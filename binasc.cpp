@@ -5,6 +5,34 @@
 // Last Modified: Thu Oct 22 16:47:41 PDT 1998
 // Last Modified: Wed Jan 30 13:22:18 PST 2013 Added VLV compiling
 // Last Modified: Sat Feb  9 22:30:18 PST 2013 Added MIDI parsing
+// Last Modified: Sun Oct 18 10:14:22 PDT 2026 Added repeat and fill
+// Last Modified: Sun Oct 18 11:02:40 PDT 2026 Added incbin
+// Last Modified: Sun Oct 18 12:31:05 PDT 2026 Added labels
+// Last Modified: Sun Oct 18 13:40:12 PDT 2026 Added string literals
+// Last Modified: Sun Oct 18 14:25:51 PDT 2026 Added hex and base64 blobs
+// Last Modified: Sun Oct 18 15:12:37 PDT 2026 8-byte decimal integers
+// Last Modified: Sun Oct 18 16:03:19 PDT 2026 Table of number encoders
+// Last Modified: Sun Oct 18 16:48:52 PDT 2026 64-bit VLVs and LEB128 words
+// Last Modified: Sun Oct 18 17:26:40 PDT 2026 Added --check option
+// Last Modified: Sun Oct 18 18:05:12 PDT 2026 Compiler moved to library
+// Last Modified: Sun Oct 18 19:12:44 PDT 2026 Listings moved to library
+// Last Modified: Sun Oct 18 19:58:31 PDT 2026 Added --serve and --connect
+// Last Modified: Sun Oct 18 20:41:07 PDT 2026 Added --manifest
+// Last Modified: Sun Oct 18 21:17:45 PDT 2026 Added --cache
+// Last Modified: Sun Oct 18 22:03:26 PDT 2026 Added --incremental
+// Last Modified: Sun Oct 18 23:08:52 PDT 2026 Output written behind
+// Last Modified: Sun Oct 18 23:46:15 PDT 2026 Added --listing
+// Last Modified: Mon Oct 19 00:31:20 PDT 2026 Added --count-allocations
+// Last Modified: Mon Oct 19 01:14:38 PDT 2026 Added #define and #macro
+// Last Modified: Mon Oct 19 02:05:51 PDT 2026 Listings read as they go
+// Last Modified: Mon Oct 19 03:27:09 PDT 2026 MIDI tracks on --threads
+// Last Modified: Mon Oct 19 04:41:18 PDT 2026 Added --merge
+// Last Modified: Mon Oct 19 06:02:15 PDT 2026 Count only when asked
+// Last Modified: Mon Oct 19 06:15:40 PDT 2026 Added --cache-stats
+// Last Modified: Mon Oct 19 06:24:51 PDT 2026 Version date updated
+// Last Modified: Mon Oct 19 06:51:09 PDT 2026 Thread count limited
+// Last Modified: Mon Oct 19 07:18:46 PDT 2026 Added --request-limit
+// Last Modified: Mon Oct 19 08:06:12 PDT 2026 Cached inputs mapped
 // Filename:      binasc.cpp
 // Syntax:        C++
 //
@@ -16,12 +44,35 @@ using namespace std;
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <new>
 
 #include <ctype.h>     
+#include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "Options.h"
-#include "FileIO.h"
+#include "BinascCompiler.h"
+#include "BinascFormatter.h"
+#include "BinascServer.h"
+#include "BinascClient.h"
+#include "BinascManifest.h"
+#include "BinascCache.h"
+#include "BinascIncremental.h"
+#include "BinascListing.h"
+#include "ByteCodec.h"
+
+// Most threads which --threads can ask for.
+#define THREADS_MAX 1024
 
 typedef unsigned char  uchar;
 typedef unsigned short ushort;
@@ -29,32 +80,66 @@ typedef unsigned long  ulong;
 
 // global variables:
 Options options;             // command-line options
-int     midiQ    = 0;        // used with --midi option
-int     commentQ = 1;        // used with --midi option
-FileIO  outputCompiled;      // output for compilation
+int     checkQ   = 0;        // used with --check option
+OutputBuffer outputCompiled; // output for compilation
+std::atomic<ulonglong> heapAllocations(0); // for --count-allocations
+int     countAllocationsQ = 0; // count in heapAllocations
 
 // function declarations:
 void checkOptions            (Options& opts);
-void compileFile             (istream& infile);
+void printAllocations        (ulonglong count, ulonglong inputSize);
+ulonglong estimateOutputSize (Options& opts);
+BinascFormat getFormat       (Options& opts);
+int  compileFile             (BinascCompiler& compiler, istream& infile);
+void printErrors             (BinascCompiler& compiler);
+void printError              (const BinascError& error);
+void printError              (int lineNumber, const char* token,
+                              const char* message);
+int  serveSocket             (const char* path);
+int  runClient               (BinascClient& client);
+int  runManifest             (const char* filename);
+int  getThreadCount          (void);
+int  openCache               (BinascCache& cache);
+int  compileCached           (BinascCompiler& compiler, BinascCache& cache);
+void printCacheCounts        (ostream& out, const BinascCache& cache);
+const char* mapInput         (const char* filename, size_t& size,
+                              string& copy);
+int  readInputs              (vector<string>& inputs);
+int  compileIncremental      (void);
+int  showListing             (const char* filename);
 void example                 (void);
 void manual                  (void);
-void outputStyleAscii        (istream& infile);
-void outputStyleBinary       (istream& infile);
-void outputStyleBoth         (istream& infile);
-void outputStyleMidiFile     (istream& infile);
-void processAsciiWord        (const char* word, int lineNumber, FileIO& out);
-void processBinaryWord       (const char* word, int lineNumber, FileIO& out);
-void processDecimalWord      (const char* word, int lineNumber, FileIO& out);
-void processHexadecimalWord  (const char* word, int lineNumber, FileIO& out);
-void processVlvWord          (const char* word, int lineNumber, FileIO& out);
-void processMidiPitchBendWord(const char* word, int lineNumber, FileIO& out);
-void processLine             (char* word, int lineNumber, FileIO& out);
+int  formatFile              (BinascFormatter& formatter, istream& infile,
+                              const char* filename);
+int  writeStandardOutput     (const uchar* data, size_t count, void* userData);
 void usage                   (const char* command);
 
-// MIDI parsing functions:
-int  readEvent               (ostream& out, istream& infile, int& trackbytes, 
-                              int& command);
-int  getVLV                  (istream& infile, int& trackbytes);
+
+//////////////////////////////
+//
+// operator new -- count each heap allocation for --count-allocations.
+//     Array and nothrow allocations come here as well.  Without the option
+//     the shared counter is left alone.
+//
+
+void* operator new(size_t size) {
+   if (countAllocationsQ) {
+      heapAllocations.fetch_add(1, std::memory_order_relaxed);
+   }
+   void* memory = malloc(size == 0 ? 1 : size);
+   if (memory == NULL) {
+      throw std::bad_alloc();
+   }
+   return memory;
+}
+
+void operator delete(void* memory) noexcept {
+   free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+   free(memory);
+}
 
 
 ///////////////////////////////////////////////////////////////////////////
@@ -62,6 +147,54 @@ int  getVLV                  (istream& infile, int& trackbytes);
 int main(int argc, char* argv[]) {
    options.setOptions(argc, argv);
    checkOptions(options);
+   if (strlen(options.getString("serve")) > 0) {
+      return serveSocket(options.getString("serve"));
+   }
+   if (strlen(options.getString("manifest")) > 0) {
+      return runManifest(options.getString("manifest"));
+   }
+   if (options.getBoolean("incremental")) {
+      return compileIncremental();
+   }
+   int listingQ = strlen(options.getString("listing")) > 0;
+   if (listingQ && !options.getBoolean("compile") && !checkQ) {
+      return showListing(options.getString("listing"));
+   }
+
+   // send the work to a server if there is one
+   BinascClient client;
+   if (strlen(options.getString("connect")) > 0) {
+      if (!client.open(options.getString("connect"))) {
+         cerr << "Error: " << client.getError() << endl;
+         exit(1);
+      }
+      return runClient(client);
+   }
+   const char* server = getenv("BINASC_SERVER");
+   if (server != NULL && *server != '\0' && !listingQ &&
+         client.open(server)) {
+      return runClient(client);
+   }
+
+   BinascCompiler compiler;
+   compiler.setOutput(outputCompiled);
+   compiler.setKeepGoing(checkQ);
+   BinascCache cache;
+   if (options.getBoolean("compile") && !checkQ && !listingQ &&
+         openCache(cache)) {
+      return compileCached(compiler, cache);
+   }
+   ulonglong allocations = heapAllocations;
+   BinascListing listing;
+   if (listingQ && !checkQ) {
+      if (!listing.open(options.getString("listing"))) {
+         cerr << "Error: " << listing.getError() << endl;
+         exit(1);
+      }
+      compiler.setListing(&listing);
+   }
+   BinascFormatter formatter;
+   formatter.setFormat(getFormat(options));
    ifstream infile;
    istream* input;
    const char* filename;
@@ -80,16 +213,15 @@ int main(int argc, char* argv[]) {
          input = &infile;
       }
       
-      if (options.getBoolean("compile")) {
-         compileFile(*input);
-      } else if (options.getBoolean("binary")) {
-         outputStyleBinary(*input);
-      } else if (options.getBoolean("ascii")) {
-         outputStyleAscii(*input);
-      } else if (options.getBoolean("midi")) {
-         outputStyleMidiFile(*input);
-      } else {
-         outputStyleBoth(*input);
+      if (options.getBoolean("compile") || checkQ) {
+         listing.beginSource(filecount == 0 ? "" : filename);
+         if (!compileFile(compiler, *input) && !checkQ) {
+            exit(1);
+         }
+      } else if (!formatFile(formatter, *input,
+            filecount == 0 ? NULL : filename)) {
+         cerr << formatter.getError() << endl;
+         exit(1);
       }
 
       if (input == &infile) {
@@ -98,7 +230,30 @@ int main(int argc, char* argv[]) {
 
    }
 
-   return 0;
+   if (options.getBoolean("compile") || checkQ) {
+      compiler.finish();
+      printErrors(compiler);
+      if (options.getBoolean("count-allocations")) {
+         printAllocations(heapAllocations - allocations,
+               compiler.getInputSize());
+      }
+   }
+   outputCompiled.close();
+   if (!outputCompiled.good()) {
+      cerr << "Error: " << outputCompiled.getError() << endl;
+      return 1;
+   }
+   listing.close();
+   if (!listing.good()) {
+      cerr << "Error: " << listing.getError() << endl;
+      return 1;
+   }
+   int errorCount = compiler.getErrorCount();
+   if (checkQ && errorCount > 0) {
+      cerr << errorCount << (errorCount == 1 ? " error" : " errors") 
+           << " found" << endl;
+   }
+   return errorCount > 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -115,8 +270,21 @@ void checkOptions(Options& opts) {
    opts.define("a|ascii=b");
    opts.define("b|binary=b");
    opts.define("c|compile=s:");
+   opts.define("check=b");                // check input without compiling
+   opts.define("serve=s:");               // run as a server on a socket
+   opts.define("request-limit=i:256");    // for --serve, MB per request
+   opts.define("manifest=s:");            // compile a list of files
+   opts.define("threads=i:0");            // for --serve, --manifest, -m
+   opts.define("cache=s:");               // directory of compiled files
+   opts.define("cache-stats=b");          // report cache hits with -c
+   opts.define("incremental=b");          // only compile changed lines
+   opts.define("connect=s:");             // send work to a server
+   opts.define("listing=s:");             // output offsets of source lines
+   opts.define("at=s:");                  // with --listing, find an offset
+   opts.define("count-allocations=b");    // report heap use while compiling
    opts.define("h|manual=b");
    opts.define("m|midi=b");
+   opts.define("merge=b");                // -m with all tracks in one
    opts.define("mod=i:25");
    opts.define("wrap=i:75");              // for -a option
 
@@ -140,7 +308,7 @@ void checkOptions(Options& opts) {
       exit(0);
    }
    if (opts.getBoolean("version")) {
-      cout << "last edited: Thu Feb  7 21:29:39 PST 2013" << endl;
+      cout << "last edited: Mon Oct 19 06:24:51 PDT 2026" << endl;
       cout << "compiled:    " << __DATE__ << endl;
       exit(0);
    }
@@ -152,12 +320,15 @@ void checkOptions(Options& opts) {
       example();
       exit(0);
    }
-   if (opts.getBoolean("help")) {
+   if (opts.getBoolean("manual")) {
       manual();
       exit(0);
    }
-   if (opts.getBoolean("midi")) {
-      midiQ = 1;
+   countAllocationsQ = opts.getBoolean("count-allocations");
+   if (opts.getBoolean("check")) {
+      checkQ = 1;
+      outputCompiled.discard();
+      return;
    }
  
 
@@ -168,13 +339,23 @@ void checkOptions(Options& opts) {
       exit(1);
    }
 
-   if (strlen(opts.getString("compile")) > 0) {
-      outputCompiled.open(opts.getString("compile"), ios::out);
-      if (!outputCompiled.is_open()) {
+   if (strlen(opts.getString("listing")) > 0 && (opts.getBoolean("incremental")
+         || strlen(opts.getString("connect")) > 0)) {
+      cerr << "Error: --listing cannot be used with --incremental or --connect"
+           << endl;
+      exit(1);
+   }
+
+   // --incremental keeps the old output until it is no longer needed
+   if (strlen(opts.getString("compile")) > 0 &&
+         !opts.getBoolean("incremental")) {
+      if (!outputCompiled.open(opts.getString("compile"))) {
          cerr << "Error opening output file: " << opts.getString("compile") 
               << endl;
          exit(1);
       }
+      outputCompiled.preallocate(estimateOutputSize(opts));
+      outputCompiled.writeBehind();
    }
 
 }
@@ -183,1128 +364,601 @@ void checkOptions(Options& opts) {
 
 //////////////////////////////
 //
-// compileFile -- convert an ascii file with bytes
-//     specified as numbers into output stream.
+// estimateOutputSize -- guess the size of the compiled output from the
+//     sizes of the input files.  Most source bytes are written as two
+//     digits and a space, so the output is taken to be a third of the
+//     input; sources with repeats and blobs make more.  Returns 0 when
+//     reading standard input.
 //
 
-void compileFile(istream& infile) {
-   char     inputLine[1024] = {0};    // current line being processed
-   int      lineCount = 0;            // count current line being processed
+ulonglong estimateOutputSize(Options& opts) {
+   ulonglong total = 0;
+   struct stat info;
+   for (int i=1; i<=opts.getArgCount(); i++) {
+      if (stat(opts.getArg(i), &info) != 0 || !S_ISREG(info.st_mode)) {
+         return 0;
+      }
+      total += (ulonglong)info.st_size;
+   }
+   return total / 3;
+}
+
 
 
+//////////////////////////////
+//
+// compileFile -- convert an ascii file with bytes
+//     specified as numbers into output stream.  Returns 0 if there
+//     were errors.
+//
+
+int compileFile(BinascCompiler& compiler, istream& infile) {
    if (!outputCompiled.is_open()) {
       cerr << "Error: output file was not opened" << endl;
       exit(1);
    }
 
-   infile.getline(inputLine, 1024, '\n');
-   lineCount++;
-   while (!infile.eof()) {
-      processLine(inputLine, lineCount, outputCompiled);
-      infile.getline(inputLine, 1024, '\n');
-      lineCount++;
-   }
-
-   // handle cases where there is no newline at the end of a file:
-   if (infile.gcount() > 0) {
-      processLine(inputLine, lineCount, outputCompiled);
-   }
+   int status = compiler.compileStream(infile);
+   printErrors(compiler);
+   return status;
 }
 
 
 
 //////////////////////////////
 //
-// example -- gives example calls to the binasc program.
+// printErrors -- print any errors from the compiler which have not been
+//     printed yet.
 //
 
-void example(void) {
-   cout <<
-   "# display bytes a hexadecimal values and any associated ascii characters \n"
-   "       binasc filename                                                   \n"
-   "# display bytes only as associated ascii characters (suppressing spaces) \n"
-   "       binasc -a filename                                                \n"
-   "# display bytes only as hexadecimal values                               \n"
-   "       binasc -b filename                                                \n"
-   "# compile the numeric values of the input into bytes in output           \n"
-   "       binasc -c filename                                                \n"
-   << endl;
+void printErrors(BinascCompiler& compiler) {
+   static const ErrorRecord* printed = NULL;  // last error printed
+   const ErrorRecord* record = printed == NULL ?
+         compiler.getErrorRecords() : printed->next;
+   for ( ; record != NULL; record = record->next) {
+      printError(record->lineNumber, record->token, record->message);
+      printed = record;
+   }
 }
 
 
 
 //////////////////////////////
 //
-// outputStyleAscii -- read an input file and output bytes in ascii
-//    form, not displaying any blank lines.  Output words are not
-//    broken unless they are longer than 75 characters.
+// printError -- print an error in the input.
 //
 
-void outputStyleAscii (istream& infile) {
-   uchar outputWord[256] = {0};   // storage for current word
-   int index = 0;                 // current length of word
-   int lineCount = 0;             // current length of line
-   int maxLineLength = options.getInteger("wrap"); // max line length for output
-   if (maxLineLength < 1) {
-      cerr << "Error invalid colmn wrap specified" << endl;
-      exit(1);
-   }
-   uchar ch;                      // current input byte
-   int type = 0;                  // 0=space, 1=printable
-   int lastType = 0;              // 0=space, 1=printable
+void printError(const BinascError& error) {
+   printError(error.lineNumber, error.token.c_str(), error.message.c_str());
+}
 
-   infile.read((char*)&ch, 1);
-   while (!infile.eof()) {
 
-      lastType = type;
-      if (isprint(ch) && !isspace(ch)) {
-         type = 1;
-      } else {        
-         type = 0;
+void printError(int lineNumber, const char* token, const char* message) {
+   if (lineNumber == 0) {
+      cerr << "Error: ";
+   } else {
+      cerr << "Error on line " << lineNumber;
+      if (token != NULL && *token != '\0') {
+         cerr << " at token: " << token;
       }
+      cerr << endl;
+   }
+   cerr << message << endl;
+}
 
-      if (type == 1 && lastType == 0) {
-         // start of a new word.  check where to put old word
-         if (index + lineCount >= maxLineLength) {  // put on next line
-            outputWord[index] = '\0';
-            cout << '\n' << outputWord;
-            lineCount = index;
-            index = 0;
-         } else {                                   // put on current line
-            outputWord[index] = '\0';
-            if (lineCount != 0) {
-               cout << ' ';
-               lineCount++;
-            }
-            cout << outputWord;
-            lineCount += index;
-            index = 0;
-         }
-      } 
-     
-      if (type == 1) {
-         outputWord[index++] = ch;
-      }
 
-      infile.read((char*)&ch, 1);
-   }
 
-   if (index != 0) {
-      cout << endl;
+//////////////////////////////
+//
+// serveSocket -- compile and list files for clients on a Unix domain
+//     socket until the program is stopped.
+//
+
+int serveSocket(const char* path) {
+   BinascServer server;
+   int megabytes = options.getInteger("request-limit");
+   if (megabytes < 1) {
+      cerr << "Error: the request limit must be at least 1 MB" << endl;
+      return 1;
+   }
+   server.setRequestLimit((ulonglong)megabytes * 1024 * 1024);
+   if (!server.open(path)) {
+      cerr << "Error: " << server.getError() << endl;
+      return 1;
    }
+   server.run(getThreadCount());
+   cerr << "Error: " << server.getError() << endl;
+   return 1;
 }
 
 
 
 //////////////////////////////
 //
-// outputStyleBinary -- read an input file and output bytes in ascii form,
-//     hexadecimal numbers only.
+// getThreadCount -- the number of threads given with --threads, or else
+//     one for each processor.  At most THREADS_MAX threads are used.
 //
 
-void outputStyleBinary(istream& infile) {
-   uchar outputLine[256] = {0};   // storage for output line
-   int maxByteInLine = options.getInt("mod"); // max line length for output
-   if (maxByteInLine < 1) {
-      cerr << "Error invalid byte count specified" << endl;
-      exit(1);
+int getThreadCount(void) {
+   int threadCount = options.getInteger("threads");
+   if (threadCount < 1) {
+      threadCount = thread::hardware_concurrency();
+   }
+   if (threadCount > THREADS_MAX) {
+      threadCount = THREADS_MAX;
    }
-   int currentByte = 0;           // current byte output in line
-   uchar ch;                      // current input byte
+   return threadCount < 1 ? 1 : threadCount;
+}
+
+
 
-   infile.read((char*)&ch, 1);
+//////////////////////////////
+//
+// runManifest -- compile each source in a manifest into its own output
+//     file, and print how long each one took.  Errors are printed after
+//     the name of their source file.
+//
 
-   if (infile.eof()) {
-      cout << "End of the file right away!" << endl; 
+int runManifest(const char* filename) {
+   BinascManifest manifest;
+   if (!manifest.read(filename)) {
+      cerr << "Error: " << manifest.getError() << endl;
+      return 1;
+   }
+   BinascCache cache;
+   if (openCache(cache)) {
+      manifest.setCache(&cache);
    }
 
-   while (!infile.eof()) {
-      if (ch < 0x10) {
-         cout << '0';
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   int failures = manifest.run(getThreadCount());
+   chrono::duration<double, milli> elapsed = chrono::steady_clock::now()
+         - start;
+
+   cout << fixed << setprecision(2);
+   for (int i=0; i<manifest.getJobCount(); i++) {
+      const ManifestJob& job = manifest.getJob(i);
+      const char* status = "failed";
+      if (job.status == 1) {
+         status = job.cachedQ ? "cached" : "ok    ";
       }
-      cout << hex << (int)ch << ' ';
-      currentByte++;
-      if (currentByte >= maxByteInLine) {
-         cout << '\n';
-         currentByte = 0;
+      cout << setw(10) << job.milliseconds << " ms  " << status << "  "
+           << job.source << " -> " << job.output << '\n';
+      for (int j=0; j<(int)job.errors.size(); j++) {
+         cerr << job.source << ": ";
+         printError(job.errors[j]);
       }
-      infile.read((char*)&ch, 1);
    }
-
-   if (currentByte != 0) {
-      cout << endl;
+   cout << manifest.getJobCount() << " jobs, " << failures << " failed, "
+        << elapsed.count() << " ms";
+   if (cache.is_open()) {
+      cout << "; ";
+      printCacheCounts(cout, cache);
    }
+   cout << endl;
+   return failures > 0;
 }
-   
+
 
 
 //////////////////////////////
 //
-// outputStyleBoth -- read an input file and output bytes in ascii form
-//     with both hexadecimal numbers and ascii representation
+// openCache -- use the cache directory given with --cache, or else in
+//     the BINASC_CACHE environment variable.  Returns 0 if there is no
+//     cache to use.
 //
 
-void outputStyleBoth(istream& infile) {
-   uchar asciiLine[256] = {0};    // storage for output line
-   int maxByteInLine = options.getInt("mod"); // max line length for output
-   if (maxByteInLine < 1) {
-      cerr << "Error invalid byte count specified" << endl;
-      exit(1);
+int openCache(BinascCache& cache) {
+   const char* directory = options.getString("cache");
+   if (*directory == '\0') {
+      directory = getenv("BINASC_CACHE");
    }
-   int currentByte = 0;           // current byte output in line
-   int index = 0;                 // current character in asciiLine
-   uchar ch;                      // current input byte
- 
-   infile.read((char*)&ch, 1);
-   while (!infile.eof()) {
-      if (index == 0) {
-         asciiLine[index++] = ';';
-         cout << ' '; 
-      }
-      if (ch < 0x10) {
-         cout << '0';
-      }
-      cout << hex << (int)ch << ' ';
-      currentByte++;
-  
-      asciiLine[index++] = ' ';
-      if (isprint(ch)) {
-         asciiLine[index++] = ch;
-      } else {
-         asciiLine[index++] = ' ';
-      }
-      asciiLine[index++] = ' ';
-
-      if (currentByte >= maxByteInLine) {
-         cout << '\n';
-         asciiLine[index] = '\0';
-         cout << asciiLine << "\n\n"; 
-         currentByte = 0;
-         index = 0;
-      }
-      infile.read((char*)&ch, 1);
+   if (directory == NULL || *directory == '\0') {
+      return 0;
    }
-
-   if (currentByte != 0) {
-      cout << '\n';
-      asciiLine[index] = '\0';
-      cout << asciiLine << '\n' << endl;
+   if (!cache.open(directory)) {
+      cerr << "Warning: " << cache.getError() << endl;
+      return 0;
    }
+   return 1;
 }
 
 
 
 //////////////////////////////
 //
-// outputStyleMidiFile -- read an input file and output bytes parsed
-//     as a MIDI file (exit with error if not a MIDI file.
+// compileCached -- compile the input files with the -c option, copying
+//     the output from the cache if the same input was compiled before.
+//     Input files are mapped into memory rather than read, so that the
+//     key is found without a copy of them; standard input is read whole.
+//     With --cache-stats, the cache counts are printed afterwards.
+//     Returns the exit status of the program.
 //
 
-void outputStyleMidiFile(istream& infile) {
-   uchar outputLine[256] = {0};   // storage for output line
-   int currentByte = 0;           // current byte output in line
-   uchar ch;                      // current input byte
-
-   stringstream out;
-
-   infile.read((char*)&ch, 1);
-
-   if (infile.eof()) {
-      cerr << "End of the file right away!" << endl; 
-   }
-
-   // Read the MIDI file header
-
-   // The first four bytes must be the characters "MThd"
-   if (ch != 'M') { cerr << "Not a MIDI file M" << endl; exit(1); }
-   infile.read((char*)&ch, 1);
-   if (ch != 'T') { cerr << "Not a MIDI file T" << endl; exit(1); }
-   infile.read((char*)&ch, 1);
-   if (ch != 'h') { cerr << "Not a MIDI file h" << endl; exit(1); }
-   infile.read((char*)&ch, 1);
-   if (ch != 'd') { cerr << "Not a MIDI file d" << endl; exit(1); }
-   out << "+M +T +h +d";
-   if (commentQ) {
-      out << "\t\t; MIDI header chunk marker";
-   }
-   out << endl;
-
-   // The next four bytes are a big-endian byte count for the header
-   // which should nearly always be "6"
-   int headersize = 0;
-   infile.read((char*)&ch, 1); headersize = (headersize << 8) | ch;
-   infile.read((char*)&ch, 1); headersize = (headersize << 8) | ch;
-   infile.read((char*)&ch, 1); headersize = (headersize << 8) | ch;
-   infile.read((char*)&ch, 1); headersize = (headersize << 8) | ch;
-   out << "4'" << headersize;
-   if (commentQ) {
-      out << "\t\t\t; bytes to follow in header chunk";
-   }
-   out << endl;
-
-   // first number in header is two-byte file type
-   int filetype = 0;
-   infile.read((char*)&ch, 1);
-   filetype = (filetype << 8) | ch;
-   infile.read((char*)&ch, 1);
-   filetype = (filetype << 8) | ch;
-   out << "2'" << filetype;
-   if (commentQ) {
-      out << "\t\t\t; file format: Type-" << filetype << " (";
-      switch (filetype) {
-         case 0:  out << "single track"; break;
-         case 1:  out << "multitrack";   break;
-         case 2:  out << "multisegment"; break;
-         default: out << "unknown";      break;
+int compileCached(BinascCompiler& compiler, BinascCache& cache) {
+   int filecount = options.getArgCount();
+   vector<const char*> texts;
+   vector<size_t> sizes;
+   vector<string> copies(filecount + 1);
+   int i;
+   if (filecount == 0) {
+      ostringstream text;
+      text << cin.rdbuf();
+      copies[0] = text.str();
+      texts.push_back(copies[0].data());
+      sizes.push_back(copies[0].size());
+   }
+   for (i=0; i<filecount; i++) {
+      size_t size;
+      const char* text = mapInput(options.getArg(i+1), size, copies[i+1]);
+      if (text == NULL) {
+         cerr << "Error opening file: " << options.getArg(i+1) << endl;
+         exit(1);
       }
-      out << ")";
+      texts.push_back(text);
+      sizes.push_back(size);
    }
-   out << endl;
 
-   // second number in header is two-byte trackcount
-   int trackcount = 0;
-   infile.read((char*)&ch, 1);
-   trackcount = (trackcount << 8) | ch;
-   infile.read((char*)&ch, 1);
-   trackcount = (trackcount << 8) | ch;
-   out << "2'" << trackcount;
-   if (commentQ) {
-      out << "\t\t\t; number of tracks";
+   ulonglong key = cache.getKey();
+   for (i=0; i<(int)texts.size(); i++) {
+      key = cache.addToKey(key, texts[i], sizes[i]);
    }
-   out << endl;
-   
-   // third number is divisions.  This can be one of two types:
-   // regular: top bit is 0: number of ticks per quarter note
-   // SMPTE:   top bit is 1: first byte is negative frames, second is
-   //          ticks per frame.
-   uchar byte1;
-   uchar byte2;
-   infile.read((char*)&byte1, 1);
-   infile.read((char*)&byte2, 1);
-   if (byte1 & 0x80) {
-      // SMPTE divisions
-      out << "1'-" << 0xff - (uint)byte1 + 1;
-      if (commentQ) {
-         out << "\t\t\t; SMPTE frames/second";
-      }
-      out << endl;
-      out << "1'" << dec << (int)byte2;
-      if (commentQ) {
-         out << "\t\t\t; subframes per frame";
-      }
-      out << endl;
-   } else {
-      // regular divisions
-      int divisions = 0;
-      divisions = (divisions << 8) | byte1;
-      divisions = (divisions << 8) | byte2;
-      out << "2'" << divisions;
-      if (commentQ) {
-         out << "\t\t\t; ticks per quarter note";
-      }
-      out << endl;
-   }   
-   
-   // print any strange bytes in header:
-   int i;
-   for (i=0; i<headersize - 6; i++) {
-      infile.read((char*)&ch, 1);
-      if (ch < 0x10) {
-         out << '0';
-      }
-      out << hex << (int)ch;
-   }
-   if (headersize - 6 > 0) {
-      out << "\t\t\t; unknown header bytes";
-      out << endl;
-   }
-
-   int trackbytes;
-   for (i=0; i<trackcount; i++) {
-      out << "\n; TRACK " << i << " ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;" << endl;
-
-      infile.read((char*)&ch, 1);
-      // The first four bytes of a track must be the characters "MTrk"
-      if (ch != 'M') { cerr << "Not a MIDI file M2" << endl; exit(1); }
-      infile.read((char*)&ch, 1);
-      if (ch != 'T') { cerr << "Not a MIDI file T2" << endl; exit(1); }
-      infile.read((char*)&ch, 1);
-      if (ch != 'r') { cerr << "Not a MIDI file r" << endl; exit(1); }
-      infile.read((char*)&ch, 1);
-      if (ch != 'k') { cerr << "Not a MIDI file k" << endl; exit(1); }
-      out << "+M +T +r +k";
-      if (commentQ) {
-         out << "\t\t; MIDI track chunk marker";
+   int hitQ = cache.fetch(key, outputCompiled);
+   if (!hitQ) {
+      for (i=0; i<(int)texts.size(); i++) {
+         if (!compiler.compileText(texts[i], sizes[i])) {
+            break;
+         }
       }
-      out << endl;
-
-      // The next four bytes are a big-endian byte count for the track
-      int tracksize = 0;
-      infile.read((char*)&ch, 1); tracksize = (tracksize << 8) | ch;
-      infile.read((char*)&ch, 1); tracksize = (tracksize << 8) | ch;
-      infile.read((char*)&ch, 1); tracksize = (tracksize << 8) | ch;
-      infile.read((char*)&ch, 1); tracksize = (tracksize << 8) | ch;
-      out << "4'" << tracksize;
-      if (commentQ) {
-         out << "\t\t\t; bytes to follow in track chunk";
+      compiler.finish();
+      printErrors(compiler);
+   }
+   for (i=0; i<filecount; i++) {
+      if (sizes[i] > 0 && texts[i] != copies[i+1].data()) {
+         munmap((void*)texts[i], sizes[i]);
       }
-      out << endl;
-
-      trackbytes = 0;
-      int command = 0;
-   
-      // process MIDI events until the end of the track
-      while (readEvent(out, infile, trackbytes, command)) { out << "\n"; };
-      out << "\n";
-  
-      if (trackbytes != tracksize) {
-         out << "; TRACK SIZE ERROR, ACTUAL SIZE: " << trackbytes << endl;
-      }      
    }
-
-   // print #define definitions if requested.
-
-
-   // print main content of MIDI file parsing:
-   out << ends;
-   cout << out.str() << endl;
-
+   outputCompiled.close();
+   int status = 0;
+   if (!outputCompiled.good()) {
+      cerr << "Error: " << outputCompiled.getError() << endl;
+      status = 1;
+   } else if (compiler.getErrorCount() > 0) {
+      status = 1;
+   } else if (!hitQ && compiler.getIncludedFiles().empty()) {
+      cache.store(key, options.getString("compile"));
+   }
+   if (options.getBoolean("cache-stats")) {
+      printCacheCounts(cerr, cache);
+      cerr << endl;
+   }
+   return status;
 }
-   
+
 
 
 //////////////////////////////
 //
-// readEvent -- read a delta time and then a MIDI message (or meta message).
-//     returns 1 if not end-of-track meta message; 0 otherwise.
+// mapInput -- map an input file into memory.  A file which cannot be
+//     mapped, such as a pipe, is read into copy instead.  Returns NULL if
+//     the file cannot be opened.
 //
 
-int readEvent(ostream& out, istream& infile, int& trackbytes, int& command) {
-   // read and print Variable Length Value for delta ticks
-   int vlv = getVLV(infile, trackbytes);
-   out << "v" << dec << vlv << "\t";
-  
-   char byte1, byte2;
-   uchar ch;
-   infile.read((char*)&ch, 1);
-   trackbytes++;
-   if (ch < 0x80) {
-      // running status: command byte is previous one in data stream
-      out << "   ";
-   } else {
-      // midi command byte
-      out << hex << (int)ch;
-      command = ch;
-      infile.read((char*)&ch, 1);
-      trackbytes++;
-   }
-   byte1 = ch;
-   int count;
-   int i;
-   int metatype = 0;
-   switch (command & 0xf0) {
-      case 0x80:    // note-off: 2 bytes
-         out << " '" << dec << (int)byte1;
-         infile.read((char*)&ch, 1);
-         trackbytes++;
-         byte2 = ch;
-         out << " '" << dec << (int)byte2;
-         break;
-      case 0x90:    // note-on: 2 bytes
-         out << " '" << dec << (int)byte1;
-         infile.read((char*)&ch, 1);
-         trackbytes++;
-         byte2 = ch;
-         out << " '" << dec << (int)byte2;
-         break;
-      case 0xA0:    // aftertouch: 2 bytes
-         out << " '" << dec << (int)byte1;
-         infile.read((char*)&ch, 1);
-         trackbytes++;
-         byte2 = ch;
-         out << " '" << dec << (int)byte2;
-         break;
-      case 0xB0:    // continuous controller: 2 bytes
-         out << " '" << dec << (int)byte1;
-         infile.read((char*)&ch, 1);
-         trackbytes++;
-         byte2 = ch;
-         out << " '" << dec << (int)byte2;
-         break;
-      case 0xE0:    // pitch-bend: 2 bytes
-         out << " '" << dec << (int)byte1;
-         infile.read((char*)&ch, 1);
-         trackbytes++;
-         byte2 = ch;
-         out << " '" << dec << (int)byte2;
-         break;
-      case 0xC0:    // patch change: 1 bytes
-         out << " '" << dec << (int)byte1;
-         break;
-      case 0xD0:    // channel pressure: 1 bytes
-         out << " '" << dec << (int)byte1;
-         break;
-      case 0xF0:    // various system bytes: variable bytes
-         switch (command) {
-            case 0xf0:
-               break;
-            case 0xf1:
-               break;
-            case 0xf2:
-               break;
-            case 0xf3:
-               break;
-            case 0xf4:
-               break;
-            case 0xf5:
-               break;
-            case 0xf6:
-               break;
-            case 0xf7:
-               break;
-            case 0xf8:
-               break;
-            case 0xf9:
-               break;
-            case 0xfa:
-               break;
-            case 0xfb:
-               break;
-            case 0xfc:
-               break;
-            case 0xfd:
-               break;
-            case 0xfe:
-               cerr << "Error command no yet handled" << endl;
-               exit(1);
-               break;
-            case 0xff:  // meta message
-               metatype = ch;
-               out << " " << hex << metatype;
-               infile.read((char*)&ch, 1);
-               trackbytes++;
-               count = ch;
-               out << " '" << dec << count;
-               for (i=0; i<count; i++) {
-                  infile.read((char*)&ch, 1);
-                  trackbytes++;
-                  out << " " << hex << (int)ch;
-               }
-               if (metatype == 0x2f) {
-                  return 0;
-               }
-               break;
-               
-         }
-         break;
+const char* mapInput(const char* filename, size_t& size, string& copy) {
+   int fd = open(filename, O_RDONLY);
+   if (fd < 0) {
+      return NULL;
    }
-
-   return 1;
+   struct stat info;
+   void* mapping = MAP_FAILED;
+   if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+      size = (size_t)info.st_size;
+      mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+   }
+   if (mapping != MAP_FAILED) {
+      close(fd);
+      return (const char*)mapping;
+   }
+   char block[OUTPUTBUFFER_BLOCK];
+   ssize_t count;
+   while ((count = read(fd, block, sizeof(block))) > 0) {
+      copy.append(block, count);
+   }
+   close(fd);
+   size = copy.size();
+   return copy.data();
 }
 
 
 
-///////////////////////////////
+//////////////////////////////
 //
-// getVLV -- read a Variable-Length Value from the file
+// printCacheCounts -- print how many outputs were found in the cache,
+//     how many were not, and how many were added to it.
 //
 
-int getVLV(istream& infile, int& trackbytes) {
-   int output = 0;
-   uchar ch;
-   infile.read((char*)&ch, 1);
-   trackbytes++;
-   output = (output << 7) | (0x7f & ch);
-   while (ch >= 0x80) {
-      infile.read((char*)&ch, 1);
-      trackbytes++;
-      output = (output << 7) | (0x7f & ch);
-   }
-   return output;
+void printCacheCounts(ostream& out, const BinascCache& cache) {
+   out << "cache: " << cache.getHits() << " hits, " << cache.getMisses()
+       << " misses, " << cache.getStores() << " stored";
 }
 
 
 
-///////////////////////////////
+//////////////////////////////
 //
-// processLine -- read a line of input and output any specified bytes
+// compileIncremental -- compile a single input file with the -c option,
+//     only compiling the parts which have changed since the last time.
+//     Returns the exit status of the program.
 //
 
-#define WORD_SEPARATORS " \n\t"
-
-void processLine(char* inputLine, int lineCount, FileIO& out) {
-   char* word = strtok(inputLine, WORD_SEPARATORS);
-   while (word != NULL) {
-      if ((word[0] == ';') || (word[0] == '#')) {
-         return;
-      }
-      if (word[0] == '+') {
-         processAsciiWord(word, lineCount, out);
-      } else if (word[0] == 'v') {
-         processVlvWord(word, lineCount, out);
-      } else if (word[0] == 'p') {
-         processMidiPitchBendWord(word, lineCount, out);
-      } else if (strchr(word, '\'')) {
-         processDecimalWord(word, lineCount, out);
-      } else if (strchr(word, ',') || strlen(word) > 2) {
-         processBinaryWord(word, lineCount, out);
-      } else {
-         processHexadecimalWord(word, lineCount, out);
-      }
-      word = strtok(NULL, WORD_SEPARATORS);
+int compileIncremental(void) {
+   if (!options.getBoolean("compile") || options.getArgCount() != 1) {
+      cerr << "Error: --incremental needs -c and one input file" << endl;
+      return 1;
    }
+   BinascIncremental compiler;
+   int status = compiler.compile(options.getArg(1),
+         options.getString("compile"));
+   const vector<BinascError>& errors = compiler.getErrors();
+   for (int i=0; i<(int)errors.size(); i++) {
+      printError(errors[i]);
+   }
+   if (*compiler.getError() != '\0') {
+      cerr << "Error: " << compiler.getError() << endl;
+   }
+   return !status;
 }
 
 
 
-////////////////////////////
+//////////////////////////////
 //
-// processMidiPitchBendWord -- convert a floating point number in the range
-//    from +1.0 to -1.0 into a 14-point integer with -1.0 mapping to 0
-//    and +1.0 mapping to 2^15-1.  This integer will be packed into two bytes,
-//    with the LSB coming first and containing the bottom 7-bits of the 14-bit
-//    value, then the MSB coming second and containing the top 7-bits of the
-//    14-bit value.
+// printAllocations -- report the heap allocations made while compiling,
+//     for each megabyte of input text.
 //
 
-void processMidiPitchBendWord(const char* word, int lineNumber, FileIO& out) {
-   if (strlen(word) < 2) {
-      cerr << "Error on line: " << lineNumber
-           << ": 'p' needs to be followed immediately by "
-           << "a floating-point number" << endl;
-      exit(1);
+void printAllocations(ulonglong count, ulonglong inputSize) {
+   double megabytes = inputSize / (1024.0 * 1024.0);
+   cerr << count << " heap allocations while compiling " << fixed
+        << setprecision(2) << megabytes << " MB of input";
+   if (megabytes > 0.0) {
+      cerr << " (" << setprecision(1) << count / megabytes << " per MB)";
    }
-   if (!(isdigit(word[1]) || word[1] == '.' || word[1] == '-' 
-         || word[1] == '+')) {
-      cerr << "Error on line: " << lineNumber
-           << ": 'p' needs to be followed immediately by "
-           << "a floating-point number" << endl;
-      exit(1);
-   }
-   double value = strtod(&word[1], NULL);
-
-   if (value > 1.0) {
-      value = 1.0;
-   }
-   if (value < -1.0) {
-      value = -1.0;
-   }
-
-   int intval = (int)(((1 << 13)-0.5)  * (value + 1.0) + 0.5);
-   uchar LSB = intval & 0x7f;
-   uchar MSB = (intval >>  7) & 0x7f;
-   out << LSB << MSB;
+   cerr << endl;
 }
 
 
 
 //////////////////////////////
 //
-// processVlvWord -- print a number in Variable Length Value form.
-//   The int is split into 7-bit groupings, the MSB's that are zero
-//   are dropped.  A continuation bit is added as the MSbit to each
-//   7-bit grouping.  The continuation bit is "1" if there is another
-//   byte in the VLV; "0" for the last byte.  VLVs are always
-//   big-endian.  The input word starts with the character "v" followed
-//   without space by an integer.  
+// showListing -- print a listing file made while compiling, reading the
+//     bytes from the compiled file given as the input.  With --at, only
+//     the source line which produced the byte at that offset is printed.
+//     Returns the exit status of the program.
 //
 
-void processVlvWord(const char* word, int lineNumber, FileIO& out) {
-
-   if (strlen(word) < 2) {
-      cerr << "Error on line: " << lineNumber
-           << ": 'v' needs to be followed immediately by a decimal digit"
+int showListing(const char* filename) {
+   if (options.getArgCount() != 1) {
+      cerr << "Error: --listing without -c needs the compiled file as input"
            << endl;
-      exit(1);
-   }
-   if (!isdigit(word[1])) {
-      cerr << "Error on line: " << lineNumber
-           << ": 'v' needs to be followed immediately by a decimal digit"
-           << endl;
-      exit(1);
+      return 1;
    }
-   ulong value = atoi(&word[1]);
-
-   uchar byte[5];
-
-   byte[0] = (value >> 28) & 0x7f;
-   byte[1] = (value >> 21) & 0x7f;
-   byte[2] = (value >> 14) & 0x7f;
-   byte[3] = (value >>  7) & 0x7f;
-   byte[4] = (value >>  0) & 0x7f;
-
-   int i;
-   int flag = 0;
-   for (i=0; i<4; i++) {
-      if (byte[i] != 0) {
-         flag = 1;
-      }
-      if (flag) {
-         byte[i] |= 0x80;
+   ulonglong offset = LISTING_ALL;
+   const char* at = options.getString("at");
+   if (*at != '\0') {
+      char* ending;
+      errno  = 0;
+      offset = strtoull(at, &ending, 0);
+      if (errno != 0 || *ending != '\0' || offset == LISTING_ALL) {
+         cerr << "Error: invalid offset for --at: " << at << endl;
+         return 1;
       }
    }
-
-   for (i=0; i<5; i++) {
-      if (byte[i] >= 0x80 || i == 4) {
-         out << byte[i];
-      }
+   BinascListing listing;
+   OutputBuffer out;
+   out.open(writeStandardOutput, NULL);
+   int status = listing.render(filename, options.getArg(1), out, offset);
+   out.close();
+   if (!status) {
+      cerr << "Error: " << listing.getError() << endl;
    }
+   return !status;
 }
-            
+
 
 
 //////////////////////////////
 //
-// processDecimalWord -- interprets a decimal word into
-//     constituent bytes
+// readInputs -- read each input file (or standard input) into memory.
 //
 
-void processDecimalWord(const char* word, int lineNumber, FileIO& out) {
-   int length = strlen(word);       // length of ascii binary number
-   int commaIndex = -1;             // index location of comma in number
-   int leftDigits = -1;             // number of digits to left of comma
-   int rightDigits = -1;            // number of digits to right of comma
-   int byteCount = -1;              // number of bytes to output
-   int quoteIndex = -1;             // index of decimal specifier
-   int signIndex = -1;              // index of any sign for number
-   int periodIndex = -1;            // index of period for floating point
-   int endianIndex = -1;            // index of little endian specifier
-   int i = 0;
-
-   // make sure that all characters are valid
-   for (i=0; i<length; i++) {
-      switch (word[i]) {
-         case '\'':
-            if (quoteIndex != -1) {
-               cerr << "Error on line " << lineNumber << " at token: " << word 
-                    << endl;
-               cerr << "extra quote in decimal number" << endl;
-               exit(1);
-            } else {
-               quoteIndex = i;
-            }
-            break;
-         case '-':
-            if (signIndex != -1) {
-               cerr << "Error on line " << lineNumber << " at token: " << word 
-                    << endl;
-               cerr << "cannot have more than two minus signs in number" 
-                    << endl;
-               exit(1);
-            } else {
-               signIndex = i;
-            }
-            if (i == 0 || word[i-1] != '\'') {
-               cerr << "Error on line " << lineNumber << " at token: " << word 
-                    << endl;
-               cerr << "minus sign must immediately follow quote mark" << endl;
-               exit(1);
-            }
-            break;
-         case '.':
-            if (quoteIndex == -1) {
-               cerr << "Error on line " << lineNumber << " at token: " << word 
-                    << endl;
-               cerr << "cannot have decimal marker before quote" << endl;
-               exit(1);
-            }
-            if (periodIndex != -1) {
-               cerr << "Error on line " << lineNumber << " at token: " << word 
-                    << endl;
-               cerr << "extra period in decimal number" << endl;
-               exit(1);
-            } else {
-               periodIndex = i;
-            }
-            break;
-         case 'u':
-         case 'U':
-            if (quoteIndex != -1) {
-               cerr << "Error on line " << lineNumber << " at token: " << word 
-                    << endl;
-               cerr << "cannot have endian specified after quote" << endl;
-               exit(1);
-            }
-            if (endianIndex != -1) {
-               cerr << "Error on line " << lineNumber << " at token: " << word 
-                    << endl;
-               cerr << "extra \"u\" in decimal number" << endl;
-               exit(1);
-            } else {
-               endianIndex = i;
-            }
-            break;
-         case '8': 
-         case '1': case '2': case '3': case '4':
-            if (quoteIndex == -1 && byteCount != -1) {
-               cerr << "Error on line " << lineNumber << " at token: " << word 
-                    << endl;
-               cerr << "invalid byte specificaton before quote in "
-                    << "decimal number" << endl;
-               exit(1);
-            } else if (quoteIndex == -1) {
-               byteCount = word[i] - '0';
-            }
-            break;
-         case '0': case '5': case '6': case '7': case '9':
-            if (quoteIndex == -1) {
-               cerr << "Error on line " << lineNumber << " at token: " << word 
-                    << endl;
-               cerr << "cannot have numbers before quote in decimal number" 
-                    << endl;
-               exit(1);
-            }
-            break;
-         default:
-            cerr << "Error on line " << lineNumber << " at token: " << word 
-                 << endl;
-            cerr << "Invalid character in decimal number"
-                    " (character number " << i <<")" << endl;
+int readInputs(vector<string>& inputs) {
+   int filecount = options.getArgCount();
+   for (int i=0; i<filecount || i==0; i++) {
+      ostringstream text;
+      if (filecount == 0) {
+         text << cin.rdbuf();
+      } else {
+         const char* filename = options.getArg(i+1);
+         ifstream infile(filename, ios::binary);
+         if (!infile.is_open()) {
+            cerr << "Error opening file: " << filename << endl;
             exit(1);
+         }
+         text << infile.rdbuf();
       }
+      inputs.push_back(text.str());
    }
+   return (int)inputs.size();
+}
 
-   // there must be a quote character to indicate a decimal number
-   // and there must be a decimal number after the quote
-   if (quoteIndex == -1) {
-      cerr << "Error on line " << lineNumber << " at token: " << word 
-           << endl;
-      cerr << "there must be a quote to signify a decimal number" << endl;
-      exit(1);
-   } else if (quoteIndex == length - 1) {
-      cerr << "Error on line " << lineNumber << " at token: " << word 
-           << endl;
-      cerr << "there must be a decimal number after the quote" << endl;
+
+
+//////////////////////////////
+//
+// runClient -- have a server compile or list the input files, in the
+//     same way as they would be done by this program.
+//
+
+int runClient(BinascClient& client) {
+   int compileQ = options.getBoolean("compile") || checkQ;
+   if (compileQ && !outputCompiled.is_open()) {
+      cerr << "Error: output file was not opened" << endl;
       exit(1);
    }
 
-   // 8 byte decimal output can only occur if reading a double number
-   if (periodIndex == -1 && byteCount == 8) {
-      cerr << "Error on line " << lineNumber << " at token: " << word 
-           << endl;
-      cerr << "only floating-point numbers can use 8 bytes" << endl;
-      exit(1);
+   int status;
+   if (compileQ) {
+      status = client.beginCompile(checkQ);
+   } else {
+      status = client.beginListing(getFormat(options));
    }
 
-   // default size for floating point numbers is 4 bytes
-   if (periodIndex != -1) {
-      if (byteCount == -1) {
-         byteCount = 4;
-      }
-   } 
-
-   // process any floating point numbers possibilities
-   if (periodIndex != -1) {
-      double doubleOutput = atof(&word[quoteIndex+1]);
-      float  floatOutput  = (float)doubleOutput;
-      switch (byteCount) {
-         case 4:
-           if (endianIndex == -1) {
-              out.writeBigEndian(floatOutput);
-           } else {
-              out.writeLittleEndian(floatOutput);
-           }
-           return;
-           break;
-         case 8:
-           if (endianIndex == -1) {
-              out.writeBigEndian(doubleOutput);
-           } else {
-              out.writeLittleEndian(doubleOutput); 
-           }
-           return;
-           break;
-         default:
-            cerr << "Error on line " << lineNumber << " at token: " << word 
-                 << endl;
-            cerr << "floating-point numbers can be only 4 or 8 bytes" << endl;
-            exit(1);
+   ifstream infile;
+   int filecount = options.getArgCount();
+   for (int i=0; status && (i<filecount || i==0); i++) {
+      if (filecount == 0) {
+         status = client.sendInput(cin);
+         continue;
       }
-   }
-   
-   // process any integer decimal number possibilities
-
-   // default integer size is one byte, if size is not specified, then
-   // the number must be in the one byte range and cannot overflow
-   // the byte if the size of the decimal number is not specified
-   if (byteCount == -1) {
-      if (signIndex != -1) {
-         long tempLong = atoi(&word[quoteIndex + 1]);
-         if (tempLong > 127 || tempLong < -128) {
-            cerr << "Error on line " << lineNumber << " at token: " << word 
-                 << endl;
-            cerr << "Decimal number out of range from -128 to 127" << endl;
-            exit(1);
-         }
-         char charOutput = (char)tempLong;
-         out << charOutput;
-         return;
-      } else {
-         ulong tempLong = (ulong)atoi(&word[quoteIndex + 1]);
-         uchar ucharOutput = (uchar)tempLong;
-         if (tempLong > 255) {  // or if (tempLong < 0) but already unsigned
-            cerr << "Error on line " << lineNumber << " at token: " << word 
-                 << endl;
-            cerr << "Decimal number out of range from 0 to 255" << endl;
-            exit(1);
-         }
-         out << ucharOutput;
-         return;
+      const char* filename = options.getArg(i+1);
+      infile.open(filename, ios::binary);
+      if (!infile.is_open()) {
+         cerr << "Error opening file: " << filename << endl;
+         exit(1);
       }
+      status = client.sendInput(infile);
+      infile.close();
    }
 
-   // left with an integer number with a specified number of bytes
-   switch (byteCount) {
-      case 1:
-         if (signIndex != -1) {
-            long tempLong = atoi(&word[quoteIndex + 1]);
-            char charOutput = (char)tempLong;
-            out << charOutput;
-            return;
-         } else {
-            ulong tempLong = (ulong)atoi(&word[quoteIndex + 1]);
-            uchar ucharOutput = (uchar)tempLong;
-            out << ucharOutput;
-            return;
-         }
-         break;
-      case 2:
-         if (signIndex != -1) {
-            long tempLong = atoi(&word[quoteIndex + 1]);
-            short shortOutput = (short)tempLong;
-            if (endianIndex == -1) {
-               out.writeBigEndian(shortOutput);
-            } else {
-               out.writeLittleEndian(shortOutput);
-            }
-            return;
-         } else {
-            ulong tempLong = (ulong)atoi(&word[quoteIndex + 1]);
-            ushort ushortOutput = (ushort)tempLong;
-            if (endianIndex == -1) {
-               out.writeBigEndian(ushortOutput);
-            } else {
-               out.writeLittleEndian(ushortOutput);
-            }
-            return;
-         }
-         break;
-      case 3:
-         {
-         if (signIndex != -1) {
-            cerr << "Error on line " << lineNumber << " at token: " << word 
-                 << endl;
-            cerr << "negative decimal numbers cannot be stored in 3 bytes"
-                 << endl;
-            exit(1);
-         }
-         ulong tempLong = (ulong)atoi(&word[quoteIndex + 1]);
-         uchar byte1 = (tempLong & 0x00ff0000) >> 16;
-         uchar byte2 = (tempLong & 0x0000ff00) >>  8;
-         uchar byte3 = (tempLong & 0x000000ff);
-         if (endianIndex == -1) {
-            out << byte1;
-            out << byte2;
-            out << byte3;
-         } else {
-            out << byte3;
-            out << byte2;
-            out << byte1;
-         }
-         return;
-         }
-         break;
-      case 4:
-         if (signIndex != -1) {
-            long tempLong = atoi(&word[quoteIndex + 1]);
-            if (endianIndex == -1) {
-               out.writeBigEndian(tempLong);
-            } else {
-               out.writeLittleEndian(tempLong);
-            }
-            return;
-         } else {
-            ulong tempuLong = (ulong)atoi(&word[quoteIndex + 1]);
-            if (endianIndex == -1) {
-               out.writeBigEndian(tempuLong);
-            } else {
-               out.writeLittleEndian(tempuLong);
-            }
-            return;
-         }
-         break;
-      default:
-         cerr << "Error on line " << lineNumber << " at token: " << word 
-              << endl;
-         cerr << "invalid byte count specification for decimal number" << endl;
-         exit(1);
+   OutputBuffer listing;
+   listing.open(writeStandardOutput, NULL);
+   if (status) {
+      status = client.finish(compileQ ? outputCompiled : listing);
    }
+   listing.close();
+   outputCompiled.close();
 
+   const vector<BinascError>& errors = client.getErrors();
+   for (int i=0; i<(int)errors.size(); i++) {
+      printError(errors[i]);
+   }
+   if (*client.getError() != '\0') {
+      cerr << (compileQ ? "Error: " : "") << client.getError() << endl;
+   }
+   if (!outputCompiled.good()) {
+      cerr << "Error: " << outputCompiled.getError() << endl;
+      return 1;
+   }
+   int errorCount = (int)errors.size();
+   if (checkQ && errorCount > 0) {
+      cerr << errorCount << (errorCount == 1 ? " error" : " errors") 
+           << " found" << endl;
+   }
+   return !status;
 }
 
 
 
 //////////////////////////////
 //
-// processHexadecimalWord -- interprets a hexadecimal word into
-//     its constituent byte
+// getFormat -- the listing style and layout given on the command line.
 //
 
-void processHexadecimalWord(const char* word, int lineNumber, FileIO& out) {
-   int length = strlen(word);
-   uchar outputByte;
-
-   if (length > 2) {
-      cerr << "Error on line " << lineNumber << " at token: " << word << endl;
-      cerr << "Size of hexadecimal number is too large.  Max is ff." << endl;
-      exit(1);
+BinascFormat getFormat(Options& opts) {
+   BinascFormat format;
+   if (opts.getBoolean("binary")) {
+      format.style = FORMAT_HEX;
+   } else if (opts.getBoolean("ascii")) {
+      format.style = FORMAT_ASCII;
+   } else if (opts.getBoolean("midi") || opts.getBoolean("merge")) {
+      format.style = FORMAT_MIDI;
+   } else {
+      format.style = FORMAT_BOTH;
    }
-
-   if (!isxdigit(word[0]) || (length == 2 && !isxdigit(word[1]))) {
-      cerr << "Error on line " << lineNumber << " at token: " << word << endl;
-      cerr << "Invalid character in hexadecimal number." << endl;
-      exit(1);
+   format.bytesPerLine = opts.getInteger("mod");
+   format.wrap         = opts.getInteger("wrap");
+   if (opts.getBoolean("threads")) {
+      format.threads = getThreadCount();
    }
-   
-   outputByte = (uchar)strtol(word, (char**)NULL, 16);
-   out << outputByte;
+   format.mergeQ = opts.getBoolean("merge");
+   return format;
 }
 
 
 
 //////////////////////////////
 //
-// processAsciiWord -- interprets a binary word into
-//     its constituent byte
+// formatFile -- print a listing of an input file on standard output
+//     while it is read.  For --threads and --merge, a MIDI file is mapped
+//     into memory instead.  Returns 0 if the file cannot be listed in the
+//     requested style.
 //
 
-void processAsciiWord(const char* word, int lineNumber, FileIO& out) {
-   int length = strlen(word);
-   uchar outputByte;
-  
-   if (word[0] != '+') {
-      cerr << "Error on line " << lineNumber << " at token: " << word << endl;
-      cerr << "character byte must start with \'+\' sign: " << endl;
-      exit(1);
-   }
-
-   if (length > 2) {
-      cerr << "Error on line " << lineNumber << " at token: " << word << endl;
-      cerr << "character byte word is too long -- specify only one character" 
-           << endl;
-      exit(1);
+int formatFile(BinascFormatter& formatter, istream& infile,
+      const char* filename) {
+   const BinascFormat& format = formatter.getFormat();
+   void* mapping = MAP_FAILED;
+   size_t size = 0;
+   if (format.style == FORMAT_MIDI && (format.threads > 1 ||
+         format.mergeQ) && filename != NULL) {
+      int fd = open(filename, O_RDONLY);
+      struct stat info;
+      if (fd >= 0 && fstat(fd, &info) == 0 && S_ISREG(info.st_mode) &&
+            info.st_size > 0) {
+         size = (size_t)info.st_size;
+         mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      }
+      if (fd >= 0) {
+         close(fd);
+      }
    }
 
-   if (length == 2) {
-      outputByte = (uchar)word[1];
+   OutputBuffer out;
+   out.open(writeStandardOutput, NULL);
+   int status;
+   if (mapping != MAP_FAILED) {
+      status = formatter.format((const uchar*)mapping, size, out);
+      munmap(mapping, size);
    } else {
-      outputByte = ' ';
+      status = formatter.format(infile, out);
    }
-   out << outputByte;
+   out.close();
+   return status;
 }
-  
 
 
 
 //////////////////////////////
 //
-// processBinaryWord -- interprets a binary word into
-//     its constituent byte
+// writeStandardOutput -- output sink for listings.
 //
 
-void processBinaryWord(const char* word, int lineNumber, FileIO& out) {
-   int length = strlen(word);       // length of ascii binary number
-   int commaIndex = -1;             // index location of comma in number
-   int leftDigits = -1;             // number of digits to left of comma
-   int rightDigits = -1;            // number of digits to right of comma
-   int i = 0;
-
-   // make sure that all characters are valid
-   for (i=0; i<length; i++) {
-      if (word [i] == ',') {
-         if (commaIndex != -1) {
-            cerr << "Error on line " << lineNumber << " at token: " << word 
-                 << endl;
-            cerr << "extra comma in binary number" << endl;
-            exit(1);
-         } else {
-            commaIndex = i;
-         }
-      } else if (!(word[i] == '1' || word[i] == '0')) {
-         cerr << "Error on line " << lineNumber << " at token: " << word 
-              << endl;
-         cerr << "Invalid character in binary number"
-                 " (character is " << word[i] <<")" << endl;
-         exit(1);
-      }
-   }
+int writeStandardOutput(const uchar* data, size_t count, void* userData) {
+   cout.write((const char*)data, count);
+   return cout.good();
+}
 
-   // comma cannot start or end number
-   if (commaIndex == 0) {
-      cerr << "Error on line " << lineNumber << " at token: " << word
-           << endl;
-      cerr << "cannot start binary number with a comma" << endl;
-      exit(1);
-   } else if (commaIndex == length - 1 ) {
-      cerr << "Error on line " << lineNumber << " at token: " << word
-           << endl;
-      cerr << "cannot end binary number with a comma" << endl;
-      exit(1);
-   }
 
-   // figure out how many digits there are in binary number 
-   // number must be able to fit into one byte.
-   if (commaIndex != -1) {
-      leftDigits = commaIndex;
-      rightDigits = length - commaIndex - 1;
-   } else if (length > 8) {
-      cerr << "Error on line " << lineNumber << " at token: " << word
-           << endl;
-      cerr << "too many digits in binary number" << endl;
-      exit(1);
-   }
-   // if there is a comma, then there cannot be more than 4 digits on a side
-   if (leftDigits > 4) {
-      cerr << "Error on line " << lineNumber << " at token: " << word
-           << endl;
-      cerr << "too many digits to left of comma" << endl;
-      exit(1);
-   }
-   if (rightDigits > 4) {
-      cerr << "Error on line " << lineNumber << " at token: " << word
-           << endl;
-      cerr << "too many digits to right of comma" << endl;
-      exit(1);
-   }
 
-   // OK, we have a valid binary number, so calculate the byte
-   
-   uchar output;
-   
-   // if no comma in binary number
-   if (commaIndex == -1) {
-      for (i=0; i<length; i++) {
-         output = output << 1;
-         output |= word[i] - '0';
-      }
-   } 
-   // if comma in binary number
-   else {
-      for (i=0; i<leftDigits; i++) {
-         output = output << 1;
-         output |= word[i] - '0';
-      }
-      output = output << (4-rightDigits);
-      for (i=0+commaIndex+1; i<rightDigits+commaIndex+1; i++) {
-         output = output << 1;
-         output |= word[i] - '0';
-      }
-   }
+//////////////////////////////
+//
+// example -- gives example calls to the binasc program.
+//
 
-   // send the byte to the output
-   out << output;
+void example(void) {
+   cout <<
+   "# display bytes a hexadecimal values and any associated ascii characters \n"
+   "       binasc filename                                                   \n"
+   "# display bytes only as associated ascii characters (suppressing spaces) \n"
+   "       binasc -a filename                                                \n"
+   "# display bytes only as hexadecimal values                               \n"
+   "       binasc -b filename                                                \n"
+   "# compile the numeric values of the input into bytes in output           \n"
+   "       binasc -c filename                                                \n"
+   << endl;
 }
-         
+
 
 
 //////////////////////////////
@@ -1326,6 +980,17 @@ void usage(const char* command) {
    "   -a = output only non-space printable asci words                   \n"
    "   -b = output only hexadecimal ascii numbers for each byte          \n"
    "   -c output = compiled binary file using ascii number of input      \n"
+   "   --check   = report all errors in the input without compiling it   \n"
+   "   --serve socket   = compile and list files for binasc clients      \n"
+   "   --connect socket = have a binasc server do the work               \n"
+   "   --manifest jobs  = compile each source in jobs to its output file \n"
+   "   --cache dir      = reuse outputs of sources compiled before       \n"
+   "   --cache-stats    = with -c and a cache, report cache hits         \n"
+   "   --incremental    = with -c, only compile the changed parts        \n"
+   "   --listing file   = with -c, record the output bytes of each line; \n"
+   "                      without -c, print the listing of the input     \n"
+   "   --at offset      = with --listing, print the line for one byte    \n"
+   "   --count-allocations = report heap allocations per MB of input     \n"
    "   -m = display the man page for the program                         \n"
    "   no options = combination of -a and -b options.                    \n"
    "   --options  = list of all options, aliases and defaults            \n"
@@ -1485,14 +1150,14 @@ cout <<
 "binasc decimal numbers\n"
 "\n"
 "   binasc decimal numbers, unlike hexadecimal or binary numbers, can fill\n"
-"   slots of 1-4 bytes for integers, or 4 and 8 bytes for floating-point\n"
+"   slots of 1-8 bytes for integers, or 4 and 8 bytes for floating-point\n"
 "   decimal numbers. Decimal numbers may also be either positive or\n"
 "   negative unlike the hexadecimal or binary number input.\n"
 "\n"
 "   A decimal number starts with a quote character. There are two\n"
 "   specifications which can be given just before the quote:\n"
 "\n"
-"   1. a number in the range from 1 to 4 which specifies how many bytes an\n"
+"   1. a number in the range from 1 to 8 which specifies how many bytes an\n"
 "   integer decimal number is to be stored in. Floating-point numbers can\n"
 "   be either 4 or 8 bytes in size. The default size for floating-point\n"
 "   numbers is 4 bytes if no size is specified.\n"
@@ -1509,36 +1174,57 @@ cout <<
 "\n"
 "   1234 = 0x04d2       big endian:   04 d2      little endian:   d2 04\n"
 "\n"
-"   When a byte size is not specified before the quote character (* here), the\n"
+"   When a byte size is not specified before the quote character (' here), the\n"
 "   default is 1 for integers and 4 for floating-point. When not speifying\n"
 "   a byte size, valid decimal numbers are in the range from 0 to 255, or\n"
 "   -128 to 127 if signed, i.e., the range for one-byte decimal numbers\n"
 "   is from -128 to 255, and you have to know the representation later\n"
 "   (signed or unsigned). If you specifically specify a byte size of 1,\n"
 "   then you can give any integer number value which may be truncated to\n"
-"   fit into one byte. The maxmum integer decimal number which can fill 4\n"
-"   bytes is 4294967294 or so. (hexadecimal 0xffffffff).\n"
+"   fit into one byte. The maxmum integer decimal number which can fill 8\n"
+"   bytes is 18446744073709551615 (hexadecimal 0xffffffffffffffff).\n"
 "\n"
 "   If a decimal number includes a period character (.) it is assumed to\n"
 "   be a floating-point number. Floating-point numbers can be either 4\n"
-"   or 8 bytes. Integer numbers can be between 1 and 4 bytes, but 3-byte\n"
-"   integers can only be positive.\n"
+"   or 8 bytes. Integer numbers can be between 1 and 8 bytes, and negative\n"
+"   integers are stored in two's complement form.\n"
 "\n"
 "   Examples of decimal numbers:\n"
 "                      \n"
 "     valid                     invalid \n"
 "     examples                  examples      reason\n"
-"     *0      =    0               123         does not start with a quote\n"
-"     *255    =  255             \n"
-"     1*256   =   0 (truncated)   *256         exceeds one byte in size\n"
-"     2*256   = 256\n"
-"     4*44100 = 44100\n"
-"     4u*453  = 453 (but bytes are written small to large order)\n"
-"     u4*453  = 453 (same as above)\n"
-"     2*-5    = -5  (short int)   2* -5        cannot have a space around quote\n"
-"     *3.1415 = 3.1415 (4-byte storage, float in c)\n"
-"     8*3.1415 = 3.1415 (8-byte storage, double in c)\n"
+"     '0      =    0               123         does not start with a quote\n"
+"     '255    =  255             \n"
+"     1'256   =   0 (truncated)   '256         exceeds one byte in size\n"
+"     2'256   = 256\n"
+"     4'44100 = 44100\n"
+"     4u'453  = 453 (but bytes are written small to large order)\n"
+"     u4'453  = 453 (same as above)\n"
+"     2'-5    = -5  (short int)   2' -5        cannot have a space around quote\n"
+"     '3.1415 = 3.1415 (4-byte storage, float in c)\n"
+"     8'3.1415 = 3.1415 (8-byte storage, double in c)\n"
+"\n"
+"\n"
+"binasc byte strings\n"
+"\n"
+"   Any number of bytes can be given in one word as hexadecimal digits\n"
+"   between x' and a closing quote, or as base64 text between b64' and a\n"
+"   closing quote. These two words are the same four bytes:\n"
+"\n"
+"     x'4d546864'      b64'TVRoZA=='\n"
+"\n"
+"binasc variable-length numbers\n"
 "\n"
+"   A v followed by a decimal number writes a MIDI variable-length value,\n"
+"   which is 7 bits per byte with the most significant bits first and\n"
+"   the top bit set on every byte but the last. Values up to 64 bits\n"
+"   can be given. The uleb' and sleb' words write unsigned and signed\n"
+"   LEB128 numbers, which put the least significant 7 bits first:\n"
+"\n"
+"     v0          = 00\n"
+"     v200        = 81 48\n"
+"     uleb'624485 = e5 8e 26\n"
+"     sleb'-2     = 7e\n"
 "\n"
 "binasc ascii bytes\n"
 "\n"
@@ -1546,6 +1232,174 @@ cout <<
 "   character is a separate word. For example, to place the characters\n"
 "   cat into a file, the input would be +c +a +t.\n"
 "\n"
+"   Longer text can be given as a string in double quotes, which may\n"
+"   contain spaces: \"This is a blank soundfile.\" A backslash starts\n"
+"   an escape sequence: \\n, \\r, \\t, \\0, \\\\, \\\" or \\x followed\n"
+"   by two hexadecimal digits.\n"
+"\n"
+"binasc repeated bytes\n"
+"\n"
+"   Any word can be repeated by preceding it with a decimal count and an\n"
+"   asterisk (*). For example 1024*00 writes 1024 zero bytes, and\n"
+"   16*2u'-1 writes sixteen little-endian 2-byte values of -1. The fill\n"
+"   directive writes a single byte a given number of times:\n"
+"\n"
+"     fill 65536 00     ; 64 kilobytes of zeros\n"
+"     fill 100 +a       ; 100 letter a's\n"
+"\n"
+"   Long runs of zeros are skipped over rather than written when the\n"
+"   output is a regular file, so the compiled file has holes in it.\n"
+"\n"
+"binasc labels and expressions\n"
+"\n"
+"   A word ending in a colon is a label which marks the current position\n"
+"   in the output. Decimal words can contain an expression in parentheses\n"
+"   which adds and subtracts labels and numbers, and labels may be used\n"
+"   before they are defined. This is useful for chunk sizes:\n"
+"\n"
+"     +M +T +r +k\n"
+"     4'(end-start)     ; bytes to follow in track chunk\n"
+"     start:\n"
+"     v0 ff 2f 00\n"
+"     end:\n"
+"\n"
+"   The bytes of a forward reference are filled in when the label is\n"
+"   found. When the output is a pipe rather than a file, the bytes after\n"
+"   the forward reference are kept in memory until then.\n"
+"\n"
+"binasc macros\n"
+"\n"
+"   A line starting with #define gives a name to the rest of the line,\n"
+"   and lines between #macro and #endmacro make a macro with parameters,\n"
+"   whose values are the words following the macro's name where it is\n"
+"   used. Parameters are replaced only where they are whole words:\n"
+"\n"
+"     #define TPQ 2'96\n"
+"     #macro note time key velocity\n"
+"        time 90 key velocity\n"
+"        v240 80 key 00\n"
+"     #endmacro\n"
+"     +M +T +h +d 4'6 2'0 2'1 TPQ\n"
+"     note v0 3c 40\n"
+"     note v0 3e 40\n"
+"\n"
+"   A macro must be defined before it is used and cannot be defined\n"
+"   again. Other lines starting with # are comments.\n"
+"\n"
+"binasc input checking\n"
+"\n"
+"   The --check option reads the input as if compiling it, but writes no\n"
+"   output file. Instead of stopping at the first error, every error is\n"
+"   reported with its line number, followed by the number of errors:\n"
+"\n"
+"     binasc --check source.txt\n"
+"\n"
+"binasc binary includes\n"
+"\n"
+"   The incbin directive copies the bytes of another file into the\n"
+"   output. An optional byte offset and length select part of the file:\n"
+"\n"
+"     incbin payload.bin            ; the whole file\n"
+"     incbin payload.bin 512        ; everything after the first 512 bytes\n"
+"     incbin payload.bin 512 1024   ; 1024 bytes starting at byte 512\n"
+"\n"
+"binasc servers\n"
+"\n"
+"   Running binasc many times on small files spends most of its time\n"
+"   starting up. Instead, one binasc process can be started as a server\n"
+"   on a Unix domain socket, and later runs send their work to it:\n"
+"\n"
+"     binasc --serve /tmp/binasc.sock &\n"
+"     binasc --connect /tmp/binasc.sock -c output.bin source.txt\n"
+"\n"
+"   The --threads option sets how many requests the server works on at\n"
+"   once (the default is one per processor). If the BINASC_SERVER\n"
+"   environment variable names a socket, binasc uses the server without\n"
+"   the --connect option, and does the work itself if no server is\n"
+"   running. The input files are read by the client, but files named by\n"
+"   incbin are read by the server, so give their full paths. A request\n"
+"   whose input files add up to more than 256 MB is refused; the\n"
+"   --request-limit option of the server sets another size in MB:\n"
+"\n"
+"     binasc --serve /tmp/binasc.sock --request-limit 1024 &\n"
+"\n"
+"binasc manifests\n"
+"\n"
+"   Many sources can be compiled in one run with the --manifest option.\n"
+"   Each line of the manifest gives a source file and its output file,\n"
+"   and lines starting with a semi-colon are comments:\n"
+"\n"
+"     ; jobs.txt\n"
+"     header.txt    header.bin\n"
+"     song.txt      song.mid\n"
+"\n"
+"     binasc --manifest jobs.txt --threads 8\n"
+"\n"
+"   The jobs run on several threads, and the time taken by each one is\n"
+"   printed. The output of a job with errors is removed.\n"
+"\n"
+"binasc caches\n"
+"\n"
+"   With the --cache option (or the BINASC_CACHE environment variable),\n"
+"   compiled files are kept in a directory, named by a hash of their\n"
+"   source text. When the same source is compiled again, with -c or in\n"
+"   a manifest, the output is copied from the cache without compiling.\n"
+"   Outputs which use incbin are not cached. A manifest prints how many\n"
+"   outputs were found in the cache:\n"
+"\n"
+"     binasc --cache ~/.binasc-cache --manifest jobs.txt\n"
+"\n"
+"   With -c, the --cache-stats option prints the same counts:\n"
+"\n"
+"     binasc --cache ~/.binasc-cache --cache-stats -c out.bin source.txt\n"
+"\n"
+"binasc incremental compiling\n"
+"\n"
+"   For a large source file which changes a little at a time, the\n"
+"   --incremental option compiles only the parts which have changed:\n"
+"\n"
+"     binasc --incremental -c output.bin source.txt\n"
+"\n"
+"   The source is divided into chunks of lines, and a list of the chunks\n"
+"   is kept in output.bin.chunks. Later runs compile the chunks which\n"
+"   differ from the list, and write only their bytes when the rest of\n"
+"   the output has not moved. A source with labels or macros is always\n"
+"   compiled whole.\n"
+"\n"
+"binasc MIDI listings\n"
+"\n"
+"   The -m option lists a MIDI file as binasc text with one event on\n"
+"   each line, which compiles back into the same file. With --threads,\n"
+"   the tracks of a MIDI file (but not of standard input) are listed on\n"
+"   several threads at once, and the listing is the same:\n"
+"\n"
+"     binasc -m --threads 8 orchestra.mid\n"
+"\n"
+"   The --merge option lists the events of all tracks as one track in\n"
+"   order of time, which compiles into a type-0 file. Events at the\n"
+"   same time are listed in track order, and the end-of-track messages\n"
+"   are replaced by one at the end:\n"
+"\n"
+"     binasc --merge song.mid\n"
+"\n"
+"binasc listings\n"
+"\n"
+"   The --listing option records which bytes each source line compiled\n"
+"   into while compiling, in a small binary file:\n"
+"\n"
+"     binasc -c image.bin --listing image.lst source.txt\n"
+"\n"
+"   Without -c, the listing is printed as text, giving the output offset\n"
+"   in hexadecimal, the line number and the first bytes of each line,\n"
+"   which are read from the compiled file:\n"
+"\n"
+"     binasc --listing image.lst image.bin\n"
+"\n"
+"   The --at option finds the line which made a particular byte. The\n"
+"   offset is decimal, or hexadecimal when it starts with 0x:\n"
+"\n"
+"     binasc --listing image.lst --at 0x7f3a2c10 image.bin\n"
+"\n"
 "example 1\n"
 "\n"
 "The following file will compile into a NeXT/Sun soundfile with five\n"
@@ -1586,20 +1440,20 @@ cout <<
 "\n"
 "\n"
 "+. +s +n +d      ; magic number (characters .snd)\n"
-"4*50             ; header bytes (the decimal number 50 filling 4 bytes)\n"
-"4*10             ; sample count\n"
-"4*3              ; format\n"
-"4*44100          ; srate\n"
-"4*1              ; channels\n"
+"4'50             ; header bytes (the decimal number 50 filling 4 bytes)\n"
+"4'10             ; sample count\n"
+"4'3              ; format\n"
+"4'44100          ; srate\n"
+"4'1              ; channels\n"
 "                 ; comment:\n"
 "+T +h +i +s +  +i +s +  +a +  +b +l +a +n +k +  +s +o +u +n +d +f +i +l +e +.\n"
 "\n"
 "                 ; sample data shown in various input possibilities\n"
 "00 00            ; sample 1: hexadecimal digits\n"
-"*0 *0            ; sample 2: decimal digits\n"
-"2*0              ; sample 3: decimal number 0 filling up two bytes\n"
+"'0 '0            ; sample 2: decimal digits\n"
+"2'0              ; sample 3: decimal number 0 filling up two bytes\n"
 "0000,0000 0,0    ; sample 4: binary digits\n"
-"2u*0             ; sample 5: decimal digits filling two bytes, but\n"
+"2u'0             ; sample 5: decimal digits filling two bytes, but\n"
 "                 ; using little endian byte ordering (backward).\n"
 "; end of example soundfile.\n"
 "\n"
@@ -1627,23 +1481,23 @@ cout <<
 "\n"
 "; This is a WAVE formated soundfile with 5 zero samples.\n"
 "+R +I +F +F           ; RIFF chunk descriptor\n"
-"4u.46                 ; size of the chunk in bytes\n"
+"4u'46                 ; size of the chunk in bytes\n"
 "+W +A +V +E           ; format is the type of RIFF that follows\n"
 "+f +m +t +            ; the fmt sub chunk\n"
-"4u*16                 ; number of bytes total in sub-chuck which follow\n"
-"2u*1                  ; audio format (PCM Linear)\n"
-"2u*1                  ; number of channels\n"
-"2u*44100              ; sampling rate 44100 = ac 44, 2u.44100 = 44 ac\n"
-"4u*88200              ; byte rate = srate * channels * bitspersample / 8.\n"
-"2u*2                  ; block align (bytes per sample / 8)\n"
-"2u*16                 ; bits per sample\n"
+"4u'16                 ; number of bytes total in sub-chuck which follow\n"
+"2u'1                  ; audio format (PCM Linear)\n"
+"2u'1                  ; number of channels\n"
+"2u'44100              ; sampling rate 44100 = ac 44, 2u'44100 = 44 ac\n"
+"4u'88200              ; byte rate = srate * channels * bitspersample / 8.\n"
+"2u'2                  ; block align (bytes per sample / 8)\n"
+"2u'16                 ; bits per sample\n"
 "+d +a +t +a           ; data subchunk\n"
-"4u*10                 ; size of data subchunk in bytes which follows\n"
-"2u*0                  ; sample 1\n"
-"2u*0                  ; sample 2\n"
-"2u*0                  ; sample 3\n"
-"2u*0                  ; sample 4\n"
-"2u*0                  ; sample 5\n"
+"4u'10                 ; size of data subchunk in bytes which follows\n"
+"2u'0                  ; sample 1\n"
+"2u'0                  ; sample 2\n"
+"2u'0                  ; sample 3\n"
+"2u'0                  ; sample 4\n"
+"2u'0                  ; sample 5\n"
 "; end of example wave file.\n"
 "\n"
 "\n"